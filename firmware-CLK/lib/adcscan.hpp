@@ -0,0 +1,271 @@
+#pragma once
+
+#include <Arduino.h>
+#include <wiring_private.h>
+
+#include "dmac.hpp"
+#include "pinouts.hpp"
+
+// Free running ADC for the CV inputs. The ADC scans the analog inputs from the lowest to the highest CV
+// pin without stopping and the DMA copies every result into a ring of recent scans, so reading a CV
+// input is a sum over memory instead of a blocking conversion. CV 2 (AIN5) and CV 1 (AIN7) are scanned
+// with AIN6 between them, the encoder switch, whose results are ignored.
+#define ADC_EVENT_CHANNEL 1 // Event system channel carrying the end of each conversion
+#define ADC_SCAN_CHANNELS 3 // Inputs converted per scan, AIN5 to AIN7
+#define ADC_SCAN_DEPTH 32   // Scans kept for averaging, must be a power of two. About 1.8 ms of input
+#define ADC_SCAN_SHIFT 5    // log2(ADC_SCAN_DEPTH)
+
+// CV inputs used as gates are watched by the ADC window comparator, which interrupts as soon as a
+// conversion goes above the upper threshold. The comparator has one limit for all channels, so a
+// second DMA channel rewrites it at the end of every conversion for the one that follows: the upper
+// threshold for watched gates and out of reach for the switch and the other inputs, which then never
+// trip it. Rising edges are handled within one scan, about 60 us.
+// Falling edges, and rising edges that came while the comparator was disarmed, are picked up from
+// the ring on the CV tick, so a trigger shorter than the ring is never missed.
+// The comparator sees the raw conversions, so the levels are fixed raw readings and the input
+// calibration does not apply to them. A gate only has to cross the middle of the range.
+#define ADC_GATE_THRESHOLD 2048 // Raw reading the gates switch around, half the input range
+#define ADC_GATE_HYSTERESIS 150 // Distance either side of the threshold a gate has to cross
+#define ADC_GATE_HIGH (ADC_GATE_THRESHOLD + ADC_GATE_HYSTERESIS)
+#define ADC_GATE_LOW (ADC_GATE_THRESHOLD - ADC_GATE_HYSTERESIS)
+#define ADC_WINDOW_OFF 4095 // No 12-bit result is above it
+
+// Add prototypes for functions defined in this file
+void InitADCScan();
+void StartADCScan();
+void UpdateADCWindow();
+uint16_t ReadADCScan(int input);
+uint16_t GetADCSample(int input, int scan);
+void ADCScanDone(uint8_t flags);
+uint16_t ReadADCScanMax(int input);
+void InitADCGates(void (*callback)(int input, bool state));
+void SetADCGateInput(int input, bool enabled);
+bool GetADCGateState(int input);
+void SetADCGate(int input, bool state);
+void ServiceADCGates();
+
+volatile uint16_t adcScanBuffer[ADC_SCAN_DEPTH * ADC_SCAN_CHANNELS];
+uint8_t adcScanIndex[NUM_CV_INS]; // Position of each CV input within a scan
+
+uint8_t adcGateInputs = 0;          // CV inputs used as gates, one bit each
+volatile uint8_t adcGateStates = 0; // Current state of those gates
+void (*adcGateCallback)(int input, bool state) = nullptr;
+// Comparator limits in scan order, each one written as the conversion before its channel ends
+volatile uint16_t adcWindowLimits[ADC_SCAN_CHANNELS];
+
+void InitADCScan() {
+    // The scan covers the range between the two CV inputs
+    uint8_t first = 0xFF;
+    for (int i = 0; i < NUM_CV_INS; i++) {
+        first = min(first, (uint8_t)g_APinDescription[CV_IN_PINS[i]].ulADCChannelNumber);
+    }
+    for (int i = 0; i < NUM_CV_INS; i++) {
+        adcScanIndex[i] = g_APinDescription[CV_IN_PINS[i]].ulADCChannelNumber - first;
+        pinPeripheral(CV_IN_PINS[i], PIO_ANALOG);
+    }
+
+    ADC->CTRLA.bit.ENABLE = 0;
+    while (ADC->STATUS.bit.SYNCBUSY)
+        ;
+    // 48 MHz / 64 for the ADC clock and a longer sampling time for the input impedance, about 19 us per
+    // conversion. Single 12-bit samples, the averaging is done when the inputs are read.
+    ADC->CTRLB.reg = ADC_CTRLB_PRESCALER_DIV64 | ADC_CTRLB_RESSEL_12BIT | ADC_CTRLB_FREERUN;
+    ADC->AVGCTRL.reg = ADC_AVGCTRL_SAMPLENUM_1;
+    ADC->SAMPCTRL.reg = ADC_SAMPCTRL_SAMPLEN(7);
+    ADC->INPUTCTRL.reg = ADC_INPUTCTRL_MUXPOS(first) | ADC_INPUTCTRL_MUXNEG_GND | ADC_INPUTCTRL_GAIN_DIV2 |
+                         ADC_INPUTCTRL_INPUTSCAN(ADC_SCAN_CHANNELS - 1);
+    while (ADC->STATUS.bit.SYNCBUSY)
+        ;
+
+    // One result per trigger around a descriptor that links back to itself, no interrupt unless it fails
+    ConfigureDMAChannel(DMA_CHANNEL_ADC, ADC_DMAC_ID_RESRDY, 0, ADCScanDone, DMAC_CHINTENSET_TERR);
+    DmacDescriptor &descriptor = dmaDescriptors[DMA_CHANNEL_ADC];
+    descriptor.BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_HWORD | DMAC_BTCTRL_DSTINC | DMAC_BTCTRL_BLOCKACT_NOACT;
+    descriptor.BTCNT.reg = ADC_SCAN_DEPTH * ADC_SCAN_CHANNELS;
+    descriptor.SRCADDR.reg = (uint32_t)&ADC->RESULT.reg;
+    descriptor.DSTADDR.reg = (uint32_t)(adcScanBuffer + ADC_SCAN_DEPTH * ADC_SCAN_CHANNELS);
+    descriptor.DESCADDR.reg = (uint32_t)&descriptor;
+
+    // The end of every conversion is also routed as an event to the window channel, which then writes
+    // the limit for the conversion under way. The event system clock resynchronizes it for the DMA.
+    PM->APBCMASK.reg |= PM_APBCMASK_EVSYS;
+    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID(GCLK_CLKCTRL_ID_EVSYS_0_Val + ADC_EVENT_CHANNEL) | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_CLKEN;
+    while (GCLK->STATUS.bit.SYNCBUSY)
+        ;
+    EVSYS->USER.reg = EVSYS_USER_USER(EVSYS_ID_USER_DMAC_CH_0 + DMA_CHANNEL_ADC_WINDOW) | EVSYS_USER_CHANNEL(ADC_EVENT_CHANNEL + 1);
+    EVSYS->CHANNEL.reg = EVSYS_CHANNEL_CHANNEL(ADC_EVENT_CHANNEL) | EVSYS_CHANNEL_EDGSEL_RISING_EDGE |
+                         EVSYS_CHANNEL_PATH_RESYNCHRONIZED | EVSYS_CHANNEL_EVGEN(EVSYS_ID_GEN_ADC_RESRDY);
+    ADC->EVCTRL.reg = ADC_EVCTRL_RESRDYEO;
+
+    // One limit per event around its own self-linked descriptor, the channel never interrupts
+    ConfigureDMAChannel(DMA_CHANNEL_ADC_WINDOW, 0, 0, nullptr, 0);
+    SetDMAChannelEventTrigger(DMA_CHANNEL_ADC_WINDOW);
+    DmacDescriptor &window = dmaDescriptors[DMA_CHANNEL_ADC_WINDOW];
+    window.BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_HWORD | DMAC_BTCTRL_SRCINC | DMAC_BTCTRL_BLOCKACT_NOACT;
+    window.BTCNT.reg = ADC_SCAN_CHANNELS;
+    window.SRCADDR.reg = (uint32_t)(adcWindowLimits + ADC_SCAN_CHANNELS);
+    window.DSTADDR.reg = (uint32_t)&ADC->WINLT.reg;
+    window.DESCADDR.reg = (uint32_t)&window;
+    UpdateADCWindow();
+
+    StartADCScan();
+
+    // Fill the ring once so the first readings are valid
+    delayMicroseconds(2000);
+}
+
+// Start the scan at its first channel with both DMA channels at the start of their rings. The DMA is
+// waiting before the first conversion, so every scan lands at the start of its slot, and the limit for
+// the first channel is written here since no conversion ends before it.
+void StartADCScan() {
+    ADC->CTRLA.bit.ENABLE = 0;
+    while (ADC->STATUS.bit.SYNCBUSY)
+        ;
+    StopDMAChannel(DMA_CHANNEL_ADC);
+    StopDMAChannel(DMA_CHANNEL_ADC_WINDOW);
+    StartDMAChannel(DMA_CHANNEL_ADC);
+    StartDMAChannel(DMA_CHANNEL_ADC_WINDOW);
+    ADC->WINLT.reg = adcWindowLimits[ADC_SCAN_CHANNELS - 1];
+    while (ADC->STATUS.bit.SYNCBUSY)
+        ;
+    ADC->CTRLA.bit.ENABLE = 1;
+    while (ADC->STATUS.bit.SYNCBUSY)
+        ;
+    ADC->SWTRIG.reg = ADC_SWTRIG_START;
+}
+
+// Work out the comparator limits from the watched gates. The limit after the last channel of a
+// scan is the one for the first channel of the next.
+void UpdateADCWindow() {
+    for (int channel = 0; channel < ADC_SCAN_CHANNELS; channel++) {
+        uint16_t limit = ADC_WINDOW_OFF;
+        for (int i = 0; i < NUM_CV_INS; i++) {
+            if (adcScanIndex[i] == channel && (adcGateInputs & (1 << i))) {
+                limit = ADC_GATE_HIGH;
+            }
+        }
+        adcWindowLimits[(channel + ADC_SCAN_CHANNELS - 1) % ADC_SCAN_CHANNELS] = limit;
+    }
+}
+
+// Average of the scans in the ring, 12-bit like a single conversion
+uint16_t ReadADCScan(int input) {
+    uint32_t sum = 0;
+    for (int scan = 0; scan < ADC_SCAN_DEPTH; scan++) {
+        sum += adcScanBuffer[scan * ADC_SCAN_CHANNELS + adcScanIndex[input]];
+    }
+    return sum >> ADC_SCAN_SHIFT;
+}
+
+// A single conversion of an input, scan wraps around the ring
+uint16_t GetADCSample(int input, int scan) {
+    return adcScanBuffer[(scan % ADC_SCAN_DEPTH) * ADC_SCAN_CHANNELS + adcScanIndex[input]];
+}
+
+// Only transfer errors raise the interrupt. Start the scan over so the results line up with the ring again.
+void ADCScanDone(uint8_t flags) {
+    if (flags & DMAC_CHINTFLAG_TERR) {
+        StartADCScan();
+    }
+}
+
+// Highest conversion of an input in the ring
+uint16_t ReadADCScanMax(int input) {
+    uint16_t peak = 0;
+    for (int scan = 0; scan < ADC_SCAN_DEPTH; scan++) {
+        uint16_t sample = adcScanBuffer[scan * ADC_SCAN_CHANNELS + adcScanIndex[input]];
+        if (sample > peak) {
+            peak = sample;
+        }
+    }
+    return peak;
+}
+
+// The callback runs on every gate edge, from the ADC interrupt or from ServiceADCGates()
+void InitADCGates(void (*callback)(int input, bool state)) {
+    adcGateCallback = callback;
+    ADC->WINCTRL.reg = ADC_WINCTRL_WINMODE_MODE1; // Results above WINLT
+    while (ADC->STATUS.bit.SYNCBUSY)
+        ;
+
+    // Above the render stage, so an edge is handled even in the middle of a control tick
+    NVIC_SetPriority(ADC_IRQn, 1);
+    NVIC_EnableIRQ(ADC_IRQn);
+}
+
+// Watch an input as a gate or stop watching it. A new gate starts out at the level in the ring, without
+// an edge, so the caller can apply it as it is. Also called with the interrupts held off, so their
+// state is restored rather than switched back on.
+void SetADCGateInput(int input, bool enabled) {
+    uint8_t mask = 1 << input;
+    bool high = ReadADCScanMax(input) > ADC_GATE_HIGH;
+    uint32_t primask = __get_PRIMASK();
+    noInterrupts();
+    if (enabled) {
+        // Inputs that are not watched are always low
+        if (!(adcGateInputs & mask) && high) {
+            adcGateStates |= mask;
+        }
+        adcGateInputs |= mask;
+    } else {
+        adcGateInputs &= ~mask;
+        adcGateStates &= ~mask;
+    }
+    UpdateADCWindow();
+    __set_PRIMASK(primask);
+}
+
+bool GetADCGateState(int input) {
+    return adcGateStates & (1 << input);
+}
+
+// Pass on a change of a watched gate, called with the interrupts held off
+void SetADCGate(int input, bool state) {
+    uint8_t mask = 1 << input;
+    if (!(adcGateInputs & mask) || bool(adcGateStates & mask) == state) {
+        return;
+    }
+    adcGateStates ^= mask;
+    adcGateCallback(input, state);
+}
+
+// Called on the CV tick. Gates go low once their whole ring is below the lower threshold, and the
+// comparator is armed again when every watched gate is low.
+void ServiceADCGates() {
+    if (adcGateInputs == 0) {
+        ADC->INTENCLR.reg = ADC_INTENCLR_WINMON;
+        return;
+    }
+    for (int i = 0; i < NUM_CV_INS; i++) {
+        if (!(adcGateInputs & (1 << i))) {
+            continue;
+        }
+        uint16_t peak = ReadADCScanMax(i);
+        uint32_t primask = __get_PRIMASK();
+        noInterrupts();
+        if (peak > ADC_GATE_HIGH) {
+            SetADCGate(i, true);
+        } else if (peak < ADC_GATE_LOW) {
+            SetADCGate(i, false);
+        }
+        __set_PRIMASK(primask);
+    }
+    if ((adcGateStates & adcGateInputs) == 0) {
+        ADC->INTFLAG.reg = ADC_INTFLAG_WINMON;
+        ADC->INTENSET.reg = ADC_INTENSET_WINMON;
+    }
+}
+
+// The comparator tripped, which only a watched gate can do. The ADC has already started on the next
+// input of the scan, so the result belongs to the one before. The comparator disarms itself instead
+// of firing on each scan while the gate stays high.
+void ADC_Handler() {
+    ADC->INTENCLR.reg = ADC_INTENCLR_WINMON;
+    ADC->INTFLAG.reg = ADC_INTFLAG_WINMON;
+    uint8_t channel = (ADC->INPUTCTRL.bit.INPUTOFFSET + ADC_SCAN_CHANNELS - 1) % ADC_SCAN_CHANNELS;
+    for (int i = 0; i < NUM_CV_INS; i++) {
+        if (adcScanIndex[i] == channel) {
+            SetADCGate(i, true);
+        }
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "clockcapture.hpp"
+#include "dmac.hpp"
+
+// Audio rate stream for the internal DAC. TC5 overflows at the sample rate and each overflow triggers the
+// DMA to copy the next sample into the DAC, so the sample timing never depends on the CPU. The DMA runs
+// around two blocks; while one plays, the other is refilled from the render interrupt.
+#define AUDIO_SAMPLE_RATE 32000
+#define AUDIO_BLOCK_SIZE 64 // Samples per block, 2 ms at 32 kHz
+
+// Add prototypes for functions defined in this file
+void InitAudioDAC();
+void StartAudioDAC();
+void StopAudioDAC();
+bool IsAudioDACRunning();
+int NextAudioBlock();
+void AudioBlockFilled(int block);
+void AudioBlockDone(uint8_t flags);
+
+uint16_t audioBlocks[2][AUDIO_BLOCK_SIZE];
+__attribute__((aligned(16))) DmacDescriptor audioDescriptors[2]; // Linked in a ring behind the base descriptor
+volatile uint8_t audioFreeBlocks = 0;                            // Blocks waiting to be refilled
+volatile uint8_t audioPlayingBlock = 0;
+bool audioRunning = false;
+bool audioStarting = false; // Waiting for both blocks to be filled before the first sample goes out
+
+void InitAudioDAC() {
+    PM->APBCMASK.reg |= PM_APBCMASK_TC5;
+    InitTC4TC5Clock();
+
+    // TC5 counts the 8 MHz clock up to CC0 and restarts, one overflow per sample
+    TC5->COUNT16.CTRLA.reg = TC_CTRLA_SWRST;
+    while (TC5->COUNT16.CTRLA.bit.SWRST)
+        ;
+    TC5->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_MFRQ | TC_CTRLA_PRESCALER_DIV1;
+    TC5->COUNT16.CC[0].reg = 8000000 / AUDIO_SAMPLE_RATE - 1;
+    while (TC5->COUNT16.STATUS.bit.SYNCBUSY)
+        ;
+
+    ConfigureDMAChannel(DMA_CHANNEL_AUDIO, TC5_DMAC_ID_OVF, 2, AudioBlockDone, DMAC_CHINTENSET_TCMPL | DMAC_CHINTENSET_TERR);
+}
+
+// Point a descriptor at one block, raising an interrupt when it has been played
+void SetAudioDescriptor(DmacDescriptor &descriptor, int block, DmacDescriptor *next) {
+    descriptor.BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_HWORD | DMAC_BTCTRL_SRCINC | DMAC_BTCTRL_BLOCKACT_INT;
+    descriptor.BTCNT.reg = AUDIO_BLOCK_SIZE;
+    descriptor.SRCADDR.reg = (uint32_t)(audioBlocks[block] + AUDIO_BLOCK_SIZE);
+    descriptor.DSTADDR.reg = (uint32_t)&DAC->DATA.reg;
+    descriptor.DESCADDR.reg = (uint32_t)next;
+}
+
+// Ask for both blocks to be filled, the stream starts once they are
+void StartAudioDAC() {
+    if (audioRunning) {
+        return;
+    }
+    SetAudioDescriptor(dmaDescriptors[DMA_CHANNEL_AUDIO], 0, &audioDescriptors[1]);
+    SetAudioDescriptor(audioDescriptors[1], 1, &audioDescriptors[0]);
+    SetAudioDescriptor(audioDescriptors[0], 0, &audioDescriptors[1]);
+    audioPlayingBlock = 0;
+    audioFreeBlocks = 0b11;
+    audioStarting = true;
+    audioRunning = true;
+}
+
+void StopAudioDAC() {
+    if (!audioRunning) {
+        return;
+    }
+    TC5->COUNT16.CTRLA.bit.ENABLE = 0;
+    while (TC5->COUNT16.STATUS.bit.SYNCBUSY)
+        ;
+    StopDMAChannel(DMA_CHANNEL_AUDIO);
+    audioRunning = false;
+    audioStarting = false;
+    audioFreeBlocks = 0;
+}
+
+bool IsAudioDACRunning() {
+    return audioRunning;
+}
+
+// Block that needs new samples, or -1 if both are up to date
+int NextAudioBlock() {
+    uint8_t free = audioFreeBlocks;
+    if (free == 0) {
+        return -1;
+    }
+    return (free & 1) ? 0 : 1;
+}
+
+void AudioBlockFilled(int block) {
+    noInterrupts();
+    audioFreeBlocks &= ~(1 << block);
+    interrupts();
+    if (audioStarting && audioFreeBlocks == 0) {
+        audioStarting = false;
+        StartDMAChannel(DMA_CHANNEL_AUDIO);
+        TC5->COUNT16.CTRLA.bit.ENABLE = 1;
+        while (TC5->COUNT16.STATUS.bit.SYNCBUSY)
+            ;
+    }
+}
+
+// DMA interrupt at the end of each block, the block that just finished can be refilled
+void AudioBlockDone(uint8_t flags) {
+    if (flags & DMAC_CHINTFLAG_TERR) {
+        StopAudioDAC();
+        return;
+    }
+    audioFreeBlocks |= 1 << audioPlayingBlock;
+    audioPlayingBlock ^= 1;
+}
@@ -4,6 +4,8 @@
 #include <Arduino.h>
 #include <Wire.h>
 
+#include "adcscan.hpp"
+#include "i2cdma.hpp"
 #include "pinouts.hpp"
 
 // Add prototypes for functions defined in this file
@@ -15,6 +17,7 @@ void PWM1(uint32_t duty1);
 void PWM2(uint32_t duty2);
 void PWMWrite(int pin, uint32_t value);
 void SetPin(int pin, uint32_t value);
+void WriteGate(int pin, bool state);
 
 // Create the MCP4725 object
 Adafruit_MCP4725 dac;
@@ -22,18 +25,14 @@ Adafruit_MCP4725 dac;
 
 // Handle IO devices initialization
 void InitIO() {
-    // ADC settings. These increase ADC reading stability but at the cost of cycle time. Takes around 0.7ms for one reading with these
-    REG_ADC_AVGCTRL |= ADC_AVGCTRL_SAMPLENUM_1;
-    ADC->AVGCTRL.reg = ADC_AVGCTRL_SAMPLENUM_128 | ADC_AVGCTRL_ADJRES(4);
-
     analogWriteResolution(10);
-    analogReadResolution(12);
 
     pinMode(LED_BUILTIN, OUTPUT); // LED
     pinMode(CLK_IN_PIN, INPUT);   // CLK in
     for (int i = 0; i < NUM_CV_INS; i++) {
         pinMode(CV_IN_PINS[i], INPUT); // CV in
     }
+    InitADCScan(); // The CV inputs are sampled in the background from here on
     pinMode(ENCODER_SW, INPUT_PULLUP); // push sw
     for (int i = 0; i < NUM_GATE_OUTS; i++) {
         pinMode(OUT_PINS[i], OUTPUT); // Gate out
@@ -46,7 +45,7 @@ void InitIO() {
             ;
     }
     Serial.println("MCP4725 initialized.");
-    MCP(0);                       // Set the DAC output to 0
+    dac.setVoltage(0, false);     // Set the DAC output to 0, Wire still runs the bus until InitI2CDMA()
     InternalDAC(0);               // Set the internal DAC output to 0
     digitalWrite(OUT_PIN_1, LOW); // Initialize the output pins to low
     digitalWrite(OUT_PIN_2, LOW); // Initialize the output pins to low
@@ -57,8 +56,9 @@ void InternalDAC(uint32_t value) {
     analogWrite(DAC_INTERNAL_PIN, value / 4); // "/4" -> 12bit to 10bit
 }
 
+// Queued for the DMA driver, returns straight away
 void MCP(uint32_t value) {
-    dac.setVoltage(value, false);
+    WriteDAC(value);
 }
 
 // Write to DAC pins indexed by 0
@@ -96,10 +96,10 @@ void PWMWrite(int pin, uint32_t value) {
 void SetPin(int pin, uint32_t value) {
     switch (pin) {
     case 0: // Gate Output 1
-        digitalWrite(OUT_PINS[0], value > 0 ? LOW : HIGH);
+        WriteGate(0, value > 0);
         break;
     case 1: // Gate Output 2
-        digitalWrite(OUT_PINS[1], value > 0 ? LOW : HIGH);
+        WriteGate(1, value > 0);
         break;
     case 2: // Internal DAC Output
         DACWrite(0, value);
@@ -112,3 +112,14 @@ void SetPin(int pin, uint32_t value) {
         break;
     }
 }
+
+// Write a gate output straight to the port registers, short enough to run from the timer interrupts.
+// The output stage inverts, so an active gate drives the pin low.
+void WriteGate(int pin, bool state) {
+    const PinDescription &desc = g_APinDescription[OUT_PINS[pin]];
+    if (state) {
+        PORT->Group[desc.ulPort].OUTCLR.reg = 1ul << desc.ulPin;
+    } else {
+        PORT->Group[desc.ulPort].OUTSET.reg = 1ul << desc.ulPin;
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <Arduino.h>
+#include <wiring_private.h>
+
+#include "pinouts.hpp"
+
+// Hardware timestamps for the clock input. The pin's external interrupt line raises an event that is
+// routed through the event system to TC4, which captures its free running 1 MHz counter on every rising
+// edge. Interrupt latency no longer shows up in the edge times, only in when they are processed.
+#define CAPTURE_EVENT_CHANNEL 0 // Event system channel used for the clock input
+#define CAPTURE_BUFFER_SIZE 8   // Edges waiting to be processed, must be a power of two
+#define TC4_TC5_GENERATOR 4     // Clock generator shared by TC4 and TC5
+
+// Add prototypes for functions defined in this file
+void InitTC4TC5Clock();
+void InitClockCapture(void (*callback)());
+bool ReadClockCapture(unsigned long &timestamp);
+
+volatile unsigned long captureBuffer[CAPTURE_BUFFER_SIZE];
+volatile uint8_t captureHead = 0;
+volatile uint8_t captureTail = 0;
+volatile uint16_t captureOverflows = 0; // Upper half of the 32-bit timestamps
+void (*captureCallback)() = nullptr;
+
+// TC4 and TC5 share one clock. It is 8 MHz divided from the 48 MHz DFLL, the clock of the tick timer,
+// so edge times measured here turn into tick periods without any drift between the two.
+void InitTC4TC5Clock() {
+    GCLK->GENDIV.reg = GCLK_GENDIV_ID(TC4_TC5_GENERATOR) | GCLK_GENDIV_DIV(6);
+    GCLK->GENCTRL.reg = GCLK_GENCTRL_ID(TC4_TC5_GENERATOR) | GCLK_GENCTRL_SRC_DFLL48M | GCLK_GENCTRL_GENEN;
+    while (GCLK->STATUS.bit.SYNCBUSY)
+        ;
+    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID(GCM_TC4_TC5) | GCLK_CLKCTRL_GEN(TC4_TC5_GENERATOR) | GCLK_CLKCTRL_CLKEN;
+    while (GCLK->STATUS.bit.SYNCBUSY)
+        ;
+}
+
+// Set up the capture chain, the callback runs in the capture interrupt after each edge has been buffered
+void InitClockCapture(void (*callback)()) {
+    captureCallback = callback;
+    uint32_t extInt = g_APinDescription[CLK_IN_PIN].ulExtInt;
+
+    PM->APBAMASK.reg |= PM_APBAMASK_EIC;
+    PM->APBCMASK.reg |= PM_APBCMASK_EVSYS | PM_APBCMASK_TC4;
+
+    // Rising edges on the clock input generate events instead of interrupts
+    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID(GCM_EIC) | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_CLKEN;
+    while (GCLK->STATUS.bit.SYNCBUSY)
+        ;
+    pinPeripheral(CLK_IN_PIN, PIO_EXTINT);
+    uint32_t shift = (extInt % 8) * 4;
+    EIC->CONFIG[extInt / 8].reg = (EIC->CONFIG[extInt / 8].reg & ~(EIC_CONFIG_SENSE0_Msk << shift)) | (EIC_CONFIG_SENSE0_RISE << shift);
+    EIC->INTENCLR.reg = 1 << extInt;
+    EIC->EVCTRL.reg |= 1 << extInt;
+    EIC->CTRL.bit.ENABLE = 1;
+    while (EIC->STATUS.bit.SYNCBUSY)
+        ;
+
+    // Asynchronous path from the interrupt line to TC4, so the capture does not wait on the event system clock
+    EVSYS->USER.reg = EVSYS_USER_USER(EVSYS_ID_USER_TC4_EVU) | EVSYS_USER_CHANNEL(CAPTURE_EVENT_CHANNEL + 1);
+    EVSYS->CHANNEL.reg = EVSYS_CHANNEL_CHANNEL(CAPTURE_EVENT_CHANNEL) | EVSYS_CHANNEL_EDGSEL_NO_EVT_OUTPUT |
+                         EVSYS_CHANNEL_PATH_ASYNCHRONOUS | EVSYS_CHANNEL_EVGEN(EVSYS_ID_GEN_EIC_EXTINT_0 + extInt);
+
+    // TC4 counts at 1 MHz and captures into CC0 on each event
+    InitTC4TC5Clock();
+    TC4->COUNT16.CTRLA.reg = TC_CTRLA_SWRST;
+    while (TC4->COUNT16.CTRLA.bit.SWRST)
+        ;
+    TC4->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_PRESCALER_DIV8;
+    TC4->COUNT16.CTRLC.reg = TC_CTRLC_CPTEN0;
+    while (TC4->COUNT16.STATUS.bit.SYNCBUSY)
+        ;
+    TC4->COUNT16.EVCTRL.reg = TC_EVCTRL_TCEI;
+    TC4->COUNT16.INTENSET.reg = TC_INTENSET_MC0 | TC_INTENSET_OVF;
+
+    // Same priority as the tick timer, so edges and ticks never interrupt each other
+    NVIC_SetPriority(TC4_IRQn, 0);
+    NVIC_EnableIRQ(TC4_IRQn);
+    TC4->COUNT16.CTRLA.bit.ENABLE = 1;
+    while (TC4->COUNT16.STATUS.bit.SYNCBUSY)
+        ;
+}
+
+// Take the oldest buffered edge time in microseconds, returns false when there is none
+bool ReadClockCapture(unsigned long &timestamp) {
+    if (captureTail == captureHead) {
+        return false;
+    }
+    timestamp = captureBuffer[captureTail];
+    captureTail = (captureTail + 1) % CAPTURE_BUFFER_SIZE;
+    return true;
+}
+
+void TC4_Handler() {
+    bool captured = false;
+    if (TC4->COUNT16.INTFLAG.bit.MC0) {
+        uint16_t count = TC4->COUNT16.CC[0].reg; // Reading the capture clears the flag
+        uint32_t overflows = captureOverflows;
+        // The counter wrapped after this capture was taken but the overflow is not counted yet
+        if (TC4->COUNT16.INTFLAG.bit.OVF && count < 0x8000) {
+            overflows++;
+        }
+        uint8_t next = (captureHead + 1) % CAPTURE_BUFFER_SIZE;
+        if (next != captureTail) {
+            captureBuffer[captureHead] = (overflows << 16) | count;
+            captureHead = next;
+        }
+        captured = true;
+    }
+    if (TC4->COUNT16.INTFLAG.bit.OVF) {
+        TC4->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;
+        captureOverflows++;
+    }
+    if (captured && captureCallback) {
+        captureCallback();
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <Arduino.h>
+
+// DMA controller shared by the drivers. Each driver owns one channel and its first descriptor in the
+// base table, and gets the channel's interrupt flags passed to the callback it registered.
+#define DMA_CHANNELS 4
+#define DMA_CHANNEL_I2C 0        // I2C transfers to the MCP4725 and the display
+#define DMA_CHANNEL_AUDIO 1      // Audio samples to the internal DAC
+#define DMA_CHANNEL_ADC 2        // CV input conversions into the scan ring
+#define DMA_CHANNEL_ADC_WINDOW 3 // Window comparator limit for each scan channel, event triggered
+
+// Add prototypes for functions defined in this file
+void InitDMA();
+void ConfigureDMAChannel(uint8_t channel, uint8_t trigger, uint8_t priority, void (*callback)(uint8_t flags), uint8_t interruptFlags);
+void SetDMAChannelEventTrigger(uint8_t channel);
+void StartDMAChannel(uint8_t channel);
+void StopDMAChannel(uint8_t channel);
+
+__attribute__((aligned(16))) DmacDescriptor dmaDescriptors[DMA_CHANNELS];
+__attribute__((aligned(16))) DmacDescriptor dmaWriteback[DMA_CHANNELS];
+void (*dmaCallbacks[DMA_CHANNELS])(uint8_t flags) = {};
+bool dmaReady = false;
+
+// Enable the controller, safe to call from every driver
+void InitDMA() {
+    if (dmaReady) {
+        return;
+    }
+    PM->AHBMASK.reg |= PM_AHBMASK_DMAC;
+    PM->APBBMASK.reg |= PM_APBBMASK_DMAC;
+    DMAC->CTRL.reg = 0;
+    DMAC->CTRL.reg = DMAC_CTRL_SWRST;
+    while (DMAC->CTRL.reg & DMAC_CTRL_SWRST)
+        ;
+    DMAC->BASEADDR.reg = (uint32_t)dmaDescriptors;
+    DMAC->WRBADDR.reg = (uint32_t)dmaWriteback;
+    DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xF);
+
+    // Below the clock interrupts, above the render stage
+    NVIC_SetPriority(DMAC_IRQn, 1);
+    NVIC_EnableIRQ(DMAC_IRQn);
+    dmaReady = true;
+}
+
+// Set a channel to move one beat per trigger. The callback runs on the interrupts given, transfer complete
+// (DMAC_CHINTENSET_TCMPL) and/or transfer error (DMAC_CHINTENSET_TERR).
+void ConfigureDMAChannel(uint8_t channel, uint8_t trigger, uint8_t priority, void (*callback)(uint8_t flags), uint8_t interruptFlags) {
+    InitDMA();
+    uint32_t primask = __get_PRIMASK();
+    noInterrupts();
+    dmaCallbacks[channel] = callback;
+    DMAC->CHID.reg = DMAC_CHID_ID(channel);
+    DMAC->CHCTRLA.reg = 0;
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+    while (DMAC->CHCTRLA.reg & DMAC_CHCTRLA_SWRST)
+        ;
+    DMAC->CHCTRLB.reg = DMAC_CHCTRLB_LVL(priority) | DMAC_CHCTRLB_TRIGSRC(trigger) | DMAC_CHCTRLB_TRIGACT_BEAT;
+    DMAC->CHINTENSET.reg = interruptFlags;
+    __set_PRIMASK(primask);
+}
+
+// Move one beat on every event from the event system instead of a peripheral trigger. Only channels 0
+// to 3 have an event input.
+void SetDMAChannelEventTrigger(uint8_t channel) {
+    uint32_t primask = __get_PRIMASK();
+    noInterrupts();
+    DMAC->CHID.reg = DMAC_CHID_ID(channel);
+    DMAC->CHCTRLB.reg |= DMAC_CHCTRLB_EVIE | DMAC_CHCTRLB_EVACT_TRIG;
+    __set_PRIMASK(primask);
+}
+
+// Start a channel once its descriptor has been filled in. Also called from interrupts and critical
+// sections, so the interrupt state is restored rather than switched back on.
+void StartDMAChannel(uint8_t channel) {
+    uint32_t primask = __get_PRIMASK();
+    noInterrupts();
+    DMAC->CHID.reg = DMAC_CHID_ID(channel);
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
+    __set_PRIMASK(primask);
+}
+
+void StopDMAChannel(uint8_t channel) {
+    uint32_t primask = __get_PRIMASK();
+    noInterrupts();
+    DMAC->CHID.reg = DMAC_CHID_ID(channel);
+    DMAC->CHCTRLA.reg = 0;
+    __set_PRIMASK(primask);
+}
+
+void DMAC_Handler() {
+    // Keep the channel selection of the code that was interrupted
+    uint8_t selected = DMAC->CHID.reg;
+    uint32_t pending = DMAC->INTSTATUS.reg;
+    for (uint8_t channel = 0; channel < DMA_CHANNELS; channel++) {
+        if (pending & (1 << channel)) {
+            DMAC->CHID.reg = DMAC_CHID_ID(channel);
+            uint8_t flags = DMAC->CHINTFLAG.reg;
+            DMAC->CHINTFLAG.reg = flags;
+            if (dmaCallbacks[channel]) {
+                dmaCallbacks[channel](flags);
+            }
+        }
+    }
+    DMAC->CHID.reg = selected;
+}
@@ -9,56 +9,74 @@ typedef struct {
     int pad;      // No trigger steps added to the end of the pattern
 } EuclideanParams;
 
-// Helper function to distribute the pattern based on counts and remainders
-void distributePattern(int level, int counts[], int remainders[], int pattern[], int &index) {
-    if (level == -1) {
-        pattern[index++] = 0; // Add a rest
-    } else if (level == -2) {
-        pattern[index++] = 1; // Add a trigger
-    } else {
-        for (int i = 0; i < counts[level]; i++) {
-            distributePattern(level - 1, counts, remainders, pattern, index);
-        }
-        if (remainders[level] != 0) {
-            distributePattern(level - 2, counts, remainders, pattern, index);
-        }
+// Euclidean pattern as a bitset, bit i is set when step i triggers. The padding steps after the
+// pattern are always clear.
+typedef uint64_t EuclideanPattern;
+
+// Rotate a pattern by a number of steps within its length
+inline EuclideanPattern RotatePattern(EuclideanPattern pattern, int steps, int rotation) {
+    rotation %= steps;
+    if (rotation == 0) {
+        return pattern;
     }
+    EuclideanPattern mask = steps >= 64 ? ~EuclideanPattern(0) : (EuclideanPattern(1) << steps) - 1;
+    return ((pattern << rotation) | (pattern >> (steps - rotation))) & mask;
 }
 
-// Euclidean pattern generation based on Bjorklund's algorithm
-void GeneratePattern(EuclideanParams &params, int *rhythm) {
-    // Temporary arrays for computation, we have 128 steps but currently limited to 64
-    int counts[128] = {0};
-    int remainders[128] = {0};
-    int pattern[128] = {0}; // Temporary pattern storage
-    int divisor = params.steps - params.triggers;
-    int level = 0;
+// Check if a step of the pattern triggers
+inline bool PatternStep(EuclideanPattern pattern, int step) {
+    return step < 64 && ((pattern >> step) & 1);
+}
 
-    // Step 1: Initialize counts and remainders
-    remainders[0] = params.triggers;
+// Longest pattern and the number of steps/triggers pairs up to it, triggers from 1 to steps
+static int const EuclideanMaxSteps = 64;
+static int const EuclideanTableSize = EuclideanMaxSteps * (EuclideanMaxSteps + 1) / 2;
 
-    while (true) {
-        counts[level] = divisor / remainders[level];
-        remainders[level + 1] = divisor % remainders[level];
-        divisor = remainders[level];
-        level++;
-        if (remainders[level] <= 1)
-            break;
-    }
+typedef struct {
+    EuclideanPattern patterns[EuclideanTableSize];
+} EuclideanTable;
 
-    counts[level] = divisor;
+// Position of a steps/triggers pair in the table
+constexpr int EuclideanTableIndex(int steps, int triggers) {
+    return steps * (steps - 1) / 2 + (triggers - 1);
+}
 
-    // Step 2: Distribute triggers and rests
-    int index = 0;
-    distributePattern(level, counts, remainders, pattern, index);
+// Euclidean pattern generation, Bresenham style. Step i triggers when (i * triggers) mod steps < triggers,
+// which spreads the triggers as evenly as Bjorklund's algorithm and starts on a trigger.
+constexpr EuclideanPattern BuildBasePattern(int steps, int triggers) {
+    EuclideanPattern pattern = 0;
+    int error = 0; // (i * triggers) mod steps, kept up to date without a multiply or modulo
+    for (int i = 0; i < steps; i++) {
+        if (error < triggers) {
+            pattern |= EuclideanPattern(1) << i;
+        }
+        error += triggers;
+        if (error >= steps) {
+            error -= steps;
+        }
+    }
+    return pattern;
+}
 
-    // Step 3: Rotate the pattern
-    for (int i = 0; i < params.steps; i++) {
-        rhythm[(i + params.rotation) % params.steps] = pattern[i];
+constexpr EuclideanTable BuildEuclideanTable() {
+    EuclideanTable table = {};
+    for (int steps = 1; steps <= EuclideanMaxSteps; steps++) {
+        for (int triggers = 1; triggers <= steps; triggers++) {
+            table.patterns[EuclideanTableIndex(steps, triggers)] = BuildBasePattern(steps, triggers);
+        }
     }
+    return table;
+}
+
+// Every base pattern, built by the compiler and stored in flash
+constexpr EuclideanTable euclideanTable = BuildEuclideanTable();
 
-    // Step 4: Add padding to the end of the pattern
-    for (int i = params.steps; i < params.steps + params.pad; i++) {
-        rhythm[i] = 0;
+// Look up the pattern and rotate it, cheap enough to follow CV changes
+EuclideanPattern GeneratePattern(const EuclideanParams &params) {
+    int steps = constrain(params.steps, 1, EuclideanMaxSteps);
+    if (params.triggers < 1) {
+        return 0;
     }
+    int triggers = min(params.triggers, steps);
+    return RotatePattern(euclideanTable.patterns[EuclideanTableIndex(steps, triggers)], steps, params.rotation);
 }
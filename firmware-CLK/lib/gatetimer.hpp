@@ -0,0 +1,130 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "boardIO.hpp"
+#include "pinouts.hpp"
+
+// One-shot timers that end the gate pulses, TCC1 for gate 1 and TCC2 for gate 2. The rising edge is written
+// by the tick interrupt, the timer then counts the pulse width and its overflow interrupt drops the gate, so
+// the width is exact to the microsecond instead of being rounded to whole ticks.
+
+// Timer setting for a gate width, worked out ahead of the tick interrupt so it only has to load it. The
+// prescaler is in the top byte and the count below it, so the setting is written and read in one go.
+#define GATE_TIMER_TOO_LONG 0xFFFFFFFF // The timer cannot count that far
+#define GATE_TIMER_COUNT_MASK 0xFFFFFF
+
+// Add prototypes for functions defined in this file
+void InitGateTimers();
+uint32_t GateTimerCounts(int gate, float width);
+bool StartGateTimer(int gate, uint32_t counts);
+bool IsGateTimerRunning(int gate);
+void EndGate(int gate);
+
+Tcc *const gateTimers[NUM_GATE_OUTS] = {TCC1, TCC2};
+uint32_t const gateTimerTop[NUM_GATE_OUTS] = {0xFFFFFF, 0xFFFF}; // TCC1 is 24-bit, TCC2 16-bit
+uint8_t const gatePrescalerShift[8] = {0, 1, 2, 3, 4, 6, 8, 10};  // Divisions selected by CTRLA.PRESCALER
+volatile bool gateTimerRunning[NUM_GATE_OUTS] = {false, false};
+uint8_t gatePrescaler[NUM_GATE_OUTS] = {0, 0};
+
+// The TCC1 and TCC2 clocks are shared with TCC0 and TC3, which already run from the 48 MHz generator
+void InitGateTimers() {
+    PM->APBCMASK.reg |= PM_APBCMASK_TCC1 | PM_APBCMASK_TCC2;
+    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID(GCM_TCC0_TCC1) | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_CLKEN;
+    while (GCLK->STATUS.bit.SYNCBUSY)
+        ;
+    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID(GCM_TCC2_TC3) | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_CLKEN;
+    while (GCLK->STATUS.bit.SYNCBUSY)
+        ;
+
+    for (int i = 0; i < NUM_GATE_OUTS; i++) {
+        Tcc *tcc = gateTimers[i];
+        tcc->CTRLA.reg = TCC_CTRLA_SWRST;
+        while (tcc->SYNCBUSY.bit.SWRST)
+            ;
+        tcc->CTRLA.reg = TCC_CTRLA_PRESCALER(0);
+        tcc->WAVE.reg = TCC_WAVE_WAVEGEN_NFRQ;
+        while (tcc->SYNCBUSY.bit.WAVE)
+            ;
+        // Count once up to PER and stop there
+        tcc->CTRLBSET.reg = TCC_CTRLBSET_ONESHOT;
+        while (tcc->SYNCBUSY.bit.CTRLB)
+            ;
+        tcc->INTENSET.reg = TCC_INTENSET_OVF;
+    }
+
+    // Same priority as the tick timer, so a gate is never started and ended at the same time
+    NVIC_SetPriority(TCC1_IRQn, 0);
+    NVIC_EnableIRQ(TCC1_IRQn);
+    NVIC_SetPriority(TCC2_IRQn, 0);
+    NVIC_EnableIRQ(TCC2_IRQn);
+}
+
+// Timer setting for a width in microseconds, or GATE_TIMER_TOO_LONG
+uint32_t GateTimerCounts(int gate, float width) {
+    uint64_t cycles = uint64_t(width * (F_CPU / 1000000));
+    uint8_t prescaler = 0;
+    while ((cycles >> gatePrescalerShift[prescaler]) > gateTimerTop[gate]) {
+        if (++prescaler == 8) {
+            return GATE_TIMER_TOO_LONG;
+        }
+    }
+    return (uint32_t(prescaler) << 24) | max(uint32_t(cycles >> gatePrescalerShift[prescaler]), uint32_t(1));
+}
+
+// Start the timer that ends the gate after a width set up by GateTimerCounts(). Returns false if the
+// width is longer than the timer can count, the caller then ends the gate on the tick instead.
+bool StartGateTimer(int gate, uint32_t counts) {
+    if (counts == GATE_TIMER_TOO_LONG) {
+        gateTimerRunning[gate] = false;
+        return false;
+    }
+    Tcc *tcc = gateTimers[gate];
+    uint8_t prescaler = counts >> 24;
+
+    // The prescaler can only be changed while the timer is disabled
+    if (prescaler != gatePrescaler[gate]) {
+        gatePrescaler[gate] = prescaler;
+        tcc->CTRLA.bit.ENABLE = 0;
+        while (tcc->SYNCBUSY.bit.ENABLE)
+            ;
+        tcc->CTRLA.reg = TCC_CTRLA_PRESCALER(prescaler);
+    }
+    tcc->PER.reg = counts & GATE_TIMER_COUNT_MASK;
+    while (tcc->SYNCBUSY.bit.PER)
+        ;
+    if (!tcc->CTRLA.bit.ENABLE) {
+        tcc->CTRLA.bit.ENABLE = 1;
+        while (tcc->SYNCBUSY.bit.ENABLE)
+            ;
+    }
+    tcc->CTRLBSET.reg = TCC_CTRLBSET_CMD_RETRIGGER;
+    while (tcc->SYNCBUSY.bit.CTRLB)
+        ;
+
+    // Drop an overflow left over from the previous pulse, it must not end this one
+    tcc->INTFLAG.reg = TCC_INTFLAG_OVF;
+    gateTimerRunning[gate] = true;
+    return true;
+}
+
+bool IsGateTimerRunning(int gate) {
+    return gateTimerRunning[gate];
+}
+
+// Drop the gate when its timer runs out, unless the tick interrupt already took it over
+void EndGate(int gate) {
+    gateTimers[gate]->INTFLAG.reg = TCC_INTFLAG_OVF;
+    if (gateTimerRunning[gate]) {
+        gateTimerRunning[gate] = false;
+        WriteGate(gate, false);
+    }
+}
+
+void TCC1_Handler() {
+    EndGate(0);
+}
+
+void TCC2_Handler() {
+    EndGate(1);
+}
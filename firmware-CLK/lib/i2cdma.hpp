@@ -0,0 +1,321 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "dmac.hpp"
+
+// Non-blocking I2C master for the MCP4725 and the SSD1306 on the Wire SERCOM. Wire and the Adafruit
+// drivers set the devices up, then this takes the bus over and sends every transfer by DMA, one after
+// another from the DMA interrupt. The stop is written by the DMA too, on the transmit request the
+// SERCOM raises once the last byte is out, so nothing waits for the bus. The DAC always goes first,
+// the display is cut into small chunks in between, so a display update never holds the DAC back by
+// more than one chunk. Only the columns of each page that differ from the last frame sent are
+// transferred.
+//
+// Every device gets a budget of bus bytes per budget period. Once a device has used its budget it waits
+// for the next period, leaving the bus idle for the others, so a DAC write usually finds it free.
+#define I2C_SERCOM SERCOM2 // Wire on the XIAO
+#define I2C_DMAC_ID_TX SERCOM2_DMAC_ID_TX
+#define I2C_CLOCK 1000000 // Set up by setup() through Wire, kept when the DMA takes over
+#define MCP4725_ADDRESS 0x60
+#define SSD1306_ADDRESS 0x3C
+#define DISPLAY_PAGES 8        // 8-pixel rows of the 128x64 display
+#define DISPLAY_COLUMNS 128
+#define DISPLAY_CHUNK_SIZE 16  // Display bytes per transfer, about 0.17 ms on the bus
+#define ALL_DISPLAY_PAGES 0xFF
+#define I2C_DEVICES 2
+#define I2C_DEVICE_DAC 0
+#define I2C_DEVICE_DISPLAY 1
+#define I2C_UNLIMITED_BUDGET 0
+#define DISPLAY_BUS_BUDGET 18 // Bytes per budget period, one chunk with its address and data prefix
+#define I2C_TIMEOUT_PERIODS 4 // Budget periods a transfer may take before the bus is reset, any transfer fits in one
+
+// Add prototypes for functions defined in this file
+void InitI2CDMA(const uint8_t *buffer);
+void WriteDAC(uint16_t value);
+void UpdateDisplay();
+void SendDisplay(uint8_t pages);
+bool IsDisplayBusy();
+void QueueDisplayColumns(uint8_t page, uint8_t first, uint8_t last);
+void RefillI2CBudget();
+bool HasI2CBudget(uint8_t device);
+void StartNextTransfer();
+void StartTransfer(uint8_t device, uint8_t address, const uint8_t *header, uint16_t headerLength, const uint8_t *data, uint16_t dataLength);
+void TransferDone(uint8_t flags);
+void ResetI2C();
+
+bool i2cReady = false;
+volatile bool i2cBusy = false;
+uint8_t i2cBusyPeriods = 0; // Budget periods the current transfer has been going on for
+uint32_t i2cCtrlA, i2cCtrlB, i2cBaud; // SERCOM setup as Wire left it, restored after a reset
+
+// Bus bytes each device may send per budget period and how many it has sent in the current one
+const uint16_t i2cBudget[I2C_DEVICES] = {I2C_UNLIMITED_BUDGET, DISPLAY_BUS_BUDGET};
+uint16_t i2cBudgetUsed[I2C_DEVICES] = {0, 0};
+
+// The DAC is a mailbox holding the newest code, older codes that were never sent are simply replaced
+volatile uint16_t dacPendingCode = 0;
+volatile bool dacPending = false;
+uint16_t dacLastCode = 0xFFFF; // Nothing written yet
+uint8_t dacBytes[2];
+
+// Display pages still to send, their column ranges and the position within the current one
+const uint8_t *displayBuffer = nullptr;
+uint8_t displaySent[DISPLAY_PAGES * DISPLAY_COLUMNS]; // Frame as last queued, the DMA reads from here
+volatile uint8_t displayPages = 0;
+uint8_t displayFirstColumn[DISPLAY_PAGES];
+uint8_t displayLastColumn[DISPLAY_PAGES];
+uint8_t displayPage = 0;
+uint8_t displayColumn = 0;
+bool displayWindowSent = false;
+bool displayRequeued = false; // Columns of the page on its way that changed again, sent once it is done
+uint8_t displayRequeueFirst = 0;
+uint8_t displayRequeueLast = 0;
+uint8_t displayWindow[7] = {0x00, 0x21, 0, DISPLAY_COLUMNS - 1, 0x22, 0, 0}; // Commands: column and page range
+uint8_t const displayDataPrefix = 0x40;                                     // Data follows
+__attribute__((aligned(16))) DmacDescriptor i2cDataDescriptor;
+__attribute__((aligned(16))) DmacDescriptor i2cStopDescriptor;
+uint32_t i2cStopCommand; // CTRLB as Wire set it up, with the stop command
+
+// Take the bus over from Wire, after the display and DAC have been set up with it. The buffer must
+// match what the display shows at this point, later frames are sent as changes against it.
+void InitI2CDMA(const uint8_t *buffer) {
+    displayBuffer = buffer;
+    memcpy(displaySent, buffer, sizeof(displaySent));
+    // Transfers are driven by the DMA interrupt, none of the SERCOM interrupts are used. The SERCOM
+    // handler belongs to Wire, which could not clear them in master mode anyway.
+    I2C_SERCOM->I2CM.INTENCLR.reg = SERCOM_I2CM_INTENCLR_MB | SERCOM_I2CM_INTENCLR_SB | SERCOM_I2CM_INTENCLR_ERROR;
+    i2cCtrlA = I2C_SERCOM->I2CM.CTRLA.reg;
+    i2cCtrlB = I2C_SERCOM->I2CM.CTRLB.reg;
+    i2cBaud = I2C_SERCOM->I2CM.BAUD.reg;
+    i2cStopCommand = i2cCtrlB | SERCOM_I2CM_CTRLB_CMD(3);
+    i2cStopDescriptor.BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_WORD | DMAC_BTCTRL_BLOCKACT_INT;
+    i2cStopDescriptor.BTCNT.reg = 1;
+    i2cStopDescriptor.SRCADDR.reg = (uint32_t)&i2cStopCommand;
+    i2cStopDescriptor.DSTADDR.reg = (uint32_t)&I2C_SERCOM->I2CM.CTRLB.reg;
+    i2cStopDescriptor.DESCADDR.reg = 0;
+    ConfigureDMAChannel(DMA_CHANNEL_I2C, I2C_DMAC_ID_TX, 1, TransferDone, DMAC_CHINTENSET_TCMPL | DMAC_CHINTENSET_TERR);
+    i2cReady = true;
+
+    uint32_t primask = __get_PRIMASK();
+    noInterrupts();
+    StartNextTransfer();
+    __set_PRIMASK(primask);
+}
+
+// Queue a new 12-bit code for the MCP4725, codes equal to the last one are not sent again
+void WriteDAC(uint16_t value) {
+    if (value == dacLastCode) {
+        return;
+    }
+    dacLastCode = value;
+    uint32_t primask = __get_PRIMASK();
+    noInterrupts();
+    dacPendingCode = value;
+    dacPending = true;
+    StartNextTransfer();
+    __set_PRIMASK(primask);
+}
+
+// Compare the buffer with the last frame sent and queue the changed column range of every page,
+// so redrawing a few digits costs a few dozen bytes on the bus instead of the whole kilobyte
+void UpdateDisplay() {
+    for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+        const uint8_t *source = displayBuffer + page * DISPLAY_COLUMNS;
+        uint8_t *sent = displaySent + page * DISPLAY_COLUMNS;
+        int first = 0;
+        while (first < DISPLAY_COLUMNS && source[first] == sent[first]) {
+            first++;
+        }
+        if (first == DISPLAY_COLUMNS) {
+            continue;
+        }
+        int last = DISPLAY_COLUMNS - 1;
+        while (source[last] == sent[last]) {
+            last--;
+        }
+        uint32_t primask = __get_PRIMASK();
+        noInterrupts();
+        memcpy(sent + first, source + first, last - first + 1);
+        QueueDisplayColumns(page, first, last);
+        StartNextTransfer();
+        __set_PRIMASK(primask);
+    }
+}
+
+// Send the given display pages whole, changed or not
+void SendDisplay(uint8_t pages) {
+    uint32_t primask = __get_PRIMASK();
+    noInterrupts();
+    for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+        if (pages & (1 << page)) {
+            memcpy(displaySent + page * DISPLAY_COLUMNS, displayBuffer + page * DISPLAY_COLUMNS, DISPLAY_COLUMNS);
+            QueueDisplayColumns(page, 0, DISPLAY_COLUMNS - 1);
+        }
+    }
+    StartNextTransfer();
+    __set_PRIMASK(primask);
+}
+
+bool IsDisplayBusy() {
+    return displayPages != 0;
+}
+
+// Start a new budget period, called at a fixed rate. Transfers held back for lack of budget go out now.
+// A transfer still going on after several periods has hung the bus, it is dropped and the bus reset.
+void RefillI2CBudget() {
+    uint32_t primask = __get_PRIMASK();
+    noInterrupts();
+    if (i2cBusy && ++i2cBusyPeriods > I2C_TIMEOUT_PERIODS) {
+        ResetI2C();
+    }
+    for (uint8_t device = 0; device < I2C_DEVICES; device++) {
+        i2cBudgetUsed[device] = 0;
+    }
+    StartNextTransfer();
+    __set_PRIMASK(primask);
+}
+
+// A transfer may start as long as some budget is left, it can overdraw the rest of the period
+bool HasI2CBudget(uint8_t device) {
+    return i2cBudget[device] == I2C_UNLIMITED_BUDGET || i2cBudgetUsed[device] < i2cBudget[device];
+}
+
+// Add columns to a page's range, called with interrupts off. A page that is already on its way is
+// finished first and the new columns are queued behind it, so a display that keeps changing still
+// gets every page out, and it always ends up showing the frame as it was at the last update.
+void QueueDisplayColumns(uint8_t page, uint8_t first, uint8_t last) {
+    if (displayWindowSent && page == displayPage) {
+        if (displayRequeued) {
+            first = min(first, displayRequeueFirst);
+            last = max(last, displayRequeueLast);
+        }
+        displayRequeueFirst = first;
+        displayRequeueLast = last;
+        displayRequeued = true;
+        return;
+    }
+    uint8_t mask = 1 << page;
+    if (displayPages & mask) {
+        first = min(first, displayFirstColumn[page]);
+        last = max(last, displayLastColumn[page]);
+    }
+    displayFirstColumn[page] = first;
+    displayLastColumn[page] = last;
+    displayPages |= mask;
+}
+
+// Pick the next transfer, called with interrupts off or from the DMA interrupt
+void StartNextTransfer() {
+    if (!i2cReady || i2cBusy) {
+        return;
+    }
+
+    if (dacPending && HasI2CBudget(I2C_DEVICE_DAC)) {
+        dacPending = false;
+        // Fast write command, power down bits cleared and the 12-bit code in two bytes
+        dacBytes[0] = (dacPendingCode >> 8) & 0x0F;
+        dacBytes[1] = dacPendingCode & 0xFF;
+        StartTransfer(I2C_DEVICE_DAC, MCP4725_ADDRESS, dacBytes, sizeof(dacBytes), nullptr, 0);
+        return;
+    }
+
+    if (displayPages == 0 || !HasI2CBudget(I2C_DEVICE_DISPLAY)) {
+        return;
+    }
+    if (!displayWindowSent) {
+        // Start on the lowest page left and point the display at its column range
+        displayPage = __builtin_ctz(displayPages);
+        displayColumn = displayFirstColumn[displayPage];
+        displayWindow[2] = displayColumn;
+        displayWindow[3] = displayLastColumn[displayPage];
+        displayWindow[5] = displayPage;
+        displayWindow[6] = displayPage;
+        displayWindowSent = true;
+        StartTransfer(I2C_DEVICE_DISPLAY, SSD1306_ADDRESS, displayWindow, sizeof(displayWindow), nullptr, 0);
+        return;
+    }
+    const uint8_t *chunk = displaySent + displayPage * DISPLAY_COLUMNS + displayColumn;
+    uint8_t length = min(DISPLAY_CHUNK_SIZE, displayLastColumn[displayPage] + 1 - displayColumn);
+    displayColumn += length;
+    if (displayColumn > displayLastColumn[displayPage]) {
+        displayPages &= ~(1 << displayPage);
+        displayWindowSent = false;
+        if (displayRequeued) {
+            displayRequeued = false;
+            QueueDisplayColumns(displayPage, displayRequeueFirst, displayRequeueLast);
+        }
+    }
+    StartTransfer(I2C_DEVICE_DISPLAY, SSD1306_ADDRESS, &displayDataPrefix, 1, chunk, length);
+}
+
+// Write the address and let the DMA feed the bytes. The data descriptor is linked behind the header
+// and the stop behind both, so the stop goes out on the request that would ask for another byte.
+void StartTransfer(uint8_t device, uint8_t address, const uint8_t *header, uint16_t headerLength, const uint8_t *data, uint16_t dataLength) {
+    i2cBusy = true;
+    i2cBusyPeriods = 0;
+    i2cBudgetUsed[device] += 1 + headerLength + dataLength;
+    DmacDescriptor &descriptor = dmaDescriptors[DMA_CHANNEL_I2C];
+    descriptor.BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE | DMAC_BTCTRL_SRCINC | DMAC_BTCTRL_BLOCKACT_NOACT;
+    descriptor.BTCNT.reg = headerLength;
+    descriptor.SRCADDR.reg = (uint32_t)(header + headerLength); // Incrementing sources point at their end
+    descriptor.DSTADDR.reg = (uint32_t)&I2C_SERCOM->I2CM.DATA.reg;
+    descriptor.DESCADDR.reg = data ? (uint32_t)&i2cDataDescriptor : (uint32_t)&i2cStopDescriptor;
+    if (data) {
+        i2cDataDescriptor.BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE | DMAC_BTCTRL_SRCINC | DMAC_BTCTRL_BLOCKACT_NOACT;
+        i2cDataDescriptor.BTCNT.reg = dataLength;
+        i2cDataDescriptor.SRCADDR.reg = (uint32_t)(data + dataLength);
+        i2cDataDescriptor.DSTADDR.reg = (uint32_t)&I2C_SERCOM->I2CM.DATA.reg;
+        i2cDataDescriptor.DESCADDR.reg = (uint32_t)&i2cStopDescriptor;
+    }
+    StartDMAChannel(DMA_CHANNEL_I2C);
+    I2C_SERCOM->I2CM.ADDR.reg = SERCOM_I2CM_ADDR_ADDR(address << 1);
+    while (I2C_SERCOM->I2CM.SYNCBUSY.bit.SYSOP)
+        ;
+}
+
+// DMA interrupt, the stop has been written behind the last byte. Start the next transfer.
+void TransferDone(uint8_t flags) {
+    if (!(flags & DMAC_CHINTFLAG_TCMPL)) {
+        // The DMA gave up before it reached the stop, end the transfer here
+        I2C_SERCOM->I2CM.CTRLB.bit.CMD = 3;
+    }
+    // A missing acknowledge or bus error only loses this transfer
+    I2C_SERCOM->I2CM.INTFLAG.reg = SERCOM_I2CM_INTFLAG_ERROR;
+    I2C_SERCOM->I2CM.STATUS.reg = SERCOM_I2CM_STATUS_BUSERR | SERCOM_I2CM_STATUS_ARBLOST;
+    while (I2C_SERCOM->I2CM.SYNCBUSY.bit.SYSOP)
+        ;
+    i2cBusy = false;
+    StartNextTransfer();
+}
+
+// Drop a transfer that never finished, called with interrupts off. The DMA channel is stopped with
+// its flags cleared so a late interrupt cannot end the next transfer, and the SERCOM is reset and set
+// up again as Wire had it. Whatever was lost is sent again: the DAC with its next code and the
+// display as a whole, since the column ranges already sent are not known here.
+void ResetI2C() {
+    StopDMAChannel(DMA_CHANNEL_I2C);
+    DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL | DMAC_CHINTFLAG_TERR;
+
+    I2C_SERCOM->I2CM.CTRLA.reg = SERCOM_I2CM_CTRLA_SWRST;
+    while (I2C_SERCOM->I2CM.SYNCBUSY.bit.SWRST)
+        ;
+    I2C_SERCOM->I2CM.CTRLB.reg = i2cCtrlB;
+    I2C_SERCOM->I2CM.BAUD.reg = i2cBaud;
+    I2C_SERCOM->I2CM.CTRLA.reg = i2cCtrlA;
+    while (I2C_SERCOM->I2CM.SYNCBUSY.bit.ENABLE)
+        ;
+    // The bus state starts out unknown, force it to idle so the next start is not held back
+    I2C_SERCOM->I2CM.STATUS.reg = SERCOM_I2CM_STATUS_BUSSTATE(1);
+    while (I2C_SERCOM->I2CM.SYNCBUSY.bit.SYSOP)
+        ;
+
+    dacLastCode = 0xFFFF;
+    displayWindowSent = false;
+    displayRequeued = false;
+    for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+        QueueDisplayColumns(page, 0, DISPLAY_COLUMNS - 1);
+    }
+    i2cBusy = false;
+}
@@ -3,13 +3,17 @@
 #include <Arduino.h>
 #include <FlashStorage.h>
 
+#include "modmatrix.hpp"
 #include "outputs.hpp"
 
 #define NUM_SLOTS 4
+// Changes whenever the saved layout does, settings saved with another layout are not loaded
+#define PARAMS_LAYOUT (0xC100 + CV_ROUTES)
 
 // Struct to hold params that are saved/loaded to/from EEPROM
 struct LoadSaveParams {
     boolean valid;
+    unsigned int layout;
     unsigned int BPM;
     unsigned int externalClockDivIdx;
     int divIdx[NUM_OUTPUTS];
@@ -23,9 +27,9 @@ struct LoadSaveParams {
     EuclideanParams euclideanParams[NUM_OUTPUTS];
     int phaseShift[NUM_OUTPUTS];
     int waveformType[NUM_OUTPUTS];
-    byte CVInputTarget[NUM_CV_INS];
-    int CVInputAttenuation[NUM_CV_INS];
-    int CVInputOffset[NUM_CV_INS];
+    byte CVInputTarget[NUM_CV_INS][CV_ROUTES];
+    int CVInputAttenuation[NUM_CV_INS][CV_ROUTES];
+    int CVInputOffset[NUM_CV_INS][CV_ROUTES];
     EnvelopeParams envParams[NUM_OUTPUTS];
     QuantizerParams quantizerParams[NUM_OUTPUTS];
 };
@@ -62,6 +66,7 @@ void Save(const LoadSaveParams &p, int slot) { // save setting data to flash mem
 // Load default setting data
 LoadSaveParams LoadDefaultParams() {
     LoadSaveParams p;
+    p.layout = PARAMS_LAYOUT;
     p.BPM = 120;
     p.externalClockDivIdx = 0;
     for (int i = 0; i < NUM_OUTPUTS; i++) {
@@ -80,9 +85,11 @@ LoadSaveParams LoadDefaultParams() {
         p.quantizerParams[i] = {false, 3, 4, 1, 0};
     }
     for (int i = 0; i < NUM_CV_INS; i++) {
-        p.CVInputTarget[i] = 0;
-        p.CVInputAttenuation[i] = 0;
-        p.CVInputOffset[i] = 0;
+        for (int j = 0; j < CV_ROUTES; j++) {
+            p.CVInputTarget[i][j] = 0;
+            p.CVInputAttenuation[i][j] = 0;
+            p.CVInputOffset[i][j] = 0;
+        }
     }
     return p;
 }
@@ -110,7 +117,7 @@ LoadSaveParams Load(int slot) {
         break;
     }
     interrupts();
-    if (!p.valid) {
+    if (!p.valid || p.layout != PARAMS_LAYOUT) {
         return LoadDefaultParams();
     }
     return p;
@@ -0,0 +1,34 @@
+#pragma once
+#include <stdint.h>
+
+// Xorshift32 pseudo random generator. Integer only and a few cycles per number, so it is safe to
+// call from the clock interrupt. The same seed always gives the same sequence.
+class Xorshift32 {
+  public:
+    Xorshift32(uint32_t seed = 1) { SetSeed(seed); }
+
+    // Spread the seed over all bits so close seeds give unrelated sequences
+    void SetSeed(uint32_t seed) {
+        seed += 0x9E3779B9;
+        seed = (seed ^ (seed >> 16)) * 0x85EBCA6B;
+        seed = (seed ^ (seed >> 13)) * 0xC2B2AE35;
+        seed ^= seed >> 16;
+        _state = seed ? seed : 0x6D2B79F5; // A zero state would only ever return zero
+    }
+
+    uint32_t Next() {
+        _state ^= _state << 13;
+        _state ^= _state >> 17;
+        _state ^= _state << 5;
+        return _state;
+    }
+
+    // Value from 0 to range - 1, scaled with a multiply instead of a modulo
+    uint32_t Below(uint32_t range) { return (uint64_t(Next()) * range) >> 32; }
+
+    // Value from -32768 to 32767
+    int16_t NextQ15() { return int16_t(Next() >> 16); }
+
+  private:
+    uint32_t _state;
+};
@@ -0,0 +1,137 @@
+#pragma once
+#include <stdint.h>
+
+// Sine table with 1024 steps per turn in Q15, plus one guard entry so the interpolation never wraps
+static int const SineTableBits = 10;
+static int const SineTableSize = 1 << SineTableBits;
+
+typedef struct {
+    int16_t values[SineTableSize + 1];
+} SineTable;
+
+// Curve tables with 256 steps from 0 to 1 in Q15, plus the end point
+static int const CurveTableBits = 8;
+static int const CurveTableSize = 1 << CurveTableBits;
+
+typedef struct {
+    int16_t values[CurveTableSize + 1];
+} CurveTable;
+
+// Compile time sine from its Taylor series, x in radians
+constexpr double TaylorSine(double x) {
+    // Bring x into -PI..PI where the series converges quickly
+    const double pi = 3.14159265358979323846;
+    while (x > pi) {
+        x -= 2.0 * pi;
+    }
+    while (x < -pi) {
+        x += 2.0 * pi;
+    }
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 20; n++) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+// Compile time e^x from its Taylor series, accurate enough for |x| < 10
+constexpr double TaylorExp(double x) {
+    double term = 1.0;
+    double sum = 1.0;
+    for (int n = 1; n < 60; n++) {
+        term *= x / n;
+        sum += term;
+    }
+    return sum;
+}
+
+// Compile time base 2 logarithm for x > 0, from ln(x) = 2 * atanh((x - 1) / (x + 1))
+constexpr double SeriesLog2(double x) {
+    double y = (x - 1.0) / (x + 1.0);
+    double term = y;
+    double sum = 0.0;
+    for (int n = 1; n < 60; n += 2) {
+        sum += term / n;
+        term *= y * y;
+    }
+    return 2.0 * sum / 0.69314718055994530942;
+}
+
+constexpr int16_t RoundQ15(double value) {
+    value *= 32767.0;
+    return int16_t(value < 0 ? value - 0.5 : value + 0.5);
+}
+
+constexpr SineTable BuildSineTable() {
+    SineTable table = {};
+    for (int i = 0; i <= SineTableSize; i++) {
+        table.values[i] = RoundQ15(TaylorSine(2.0 * 3.14159265358979323846 * i / SineTableSize));
+    }
+    return table;
+}
+
+// Exponential rise (e^(4t) - 1) / (e^4 - 1)
+constexpr CurveTable BuildExpRiseTable() {
+    CurveTable table = {};
+    for (int i = 0; i <= CurveTableSize; i++) {
+        table.values[i] = RoundQ15((TaylorExp(4.0 * i / CurveTableSize) - 1.0) / (TaylorExp(4.0) - 1.0));
+    }
+    return table;
+}
+
+// Exponential decay e^(-ln(1000) t)
+constexpr CurveTable BuildExpDecayTable() {
+    CurveTable table = {};
+    for (int i = 0; i <= CurveTableSize; i++) {
+        table.values[i] = RoundQ15(TaylorExp(-6.90776 * i / CurveTableSize));
+    }
+    return table;
+}
+
+// Mantissa of the base 2 logarithm, log2(1 + t)
+constexpr CurveTable BuildLog2Table() {
+    CurveTable table = {};
+    for (int i = 0; i <= CurveTableSize; i++) {
+        table.values[i] = RoundQ15(SeriesLog2(1.0 + double(i) / CurveTableSize));
+    }
+    return table;
+}
+
+// Built by the compiler and stored in flash, so the output is the same on every build
+constexpr SineTable sineTable = BuildSineTable();
+constexpr CurveTable expRiseTable = BuildExpRiseTable();
+constexpr CurveTable expDecayTable = BuildExpDecayTable();
+constexpr CurveTable log2Table = BuildLog2Table();
+
+// Linear interpolation between the table entries, the position is a 32-bit fraction of the table length
+inline int16_t LookupQ15(const int16_t *values, int bits, uint32_t position) {
+    uint32_t index = position >> (32 - bits);
+    int32_t fraction = (position >> (32 - bits - 15)) & 0x7FFF;
+    int32_t a = values[index];
+    int32_t b = values[index + 1];
+    return a + (((b - a) * fraction + 0x4000) >> 15);
+}
+
+// Interpolated sine in Q15, the phase is a full 32-bit turn
+inline int16_t SineQ15(uint32_t phase) {
+    return LookupQ15(sineTable.values, SineTableBits, phase);
+}
+
+// Base 2 logarithm in Q16 of a Q16 value of at least 1.0
+inline int32_t Log2Q16(uint32_t x) {
+    int exponent = 31 - __builtin_clz(x);
+    // Move the leading one out of the word, leaving the mantissa as a 32-bit fraction
+    uint32_t mantissa = (x << (31 - exponent)) << 1;
+    return ((exponent - 16) << 16) + (LookupQ15(log2Table.values, CurveTableBits, mantissa) << 1);
+}
+
+// Table position of a 0 to 1 fraction, clamped to the table ends
+inline uint32_t FractionToPosition(float fraction) {
+    if (fraction <= 0.0f)
+        return 0;
+    if (fraction >= 1.0f)
+        return 0xFFFFFFFF;
+    return uint32_t(fraction * 4294967040.0f); // Largest float below 2^32
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <Arduino.h>
+
+// Software phase-locked loop for the external clock input. Every input edge should land a fixed number
+// of ticks after the previous one. The filtered edge period sets the tick rate, and the tick count error
+// at each edge nudges that rate, so the ticks stay locked to the clock instead of being reset on every beat.
+class ClockSync {
+  public:
+    static constexpr long NoJump = -1;
+
+    // Ticks between two input edges, PPQN divided by the input pulses per beat
+    void SetTicksPerPulse(unsigned long ticks) {
+        if (ticks != _ticksPerPulse) {
+            _ticksPerPulse = ticks;
+            _locked = false;
+        }
+    }
+    unsigned long GetTicksPerPulse() { return _ticksPerPulse; }
+
+    // Restart the tick count on the next edge, keeping the period estimate
+    void Reset() { _locked = false; }
+
+    // Forget the clock completely, for when it has been disconnected
+    void Unlock() {
+        _locked = false;
+        _hasEdge = false;
+        _pulsePeriod = 0;
+    }
+
+    // Process an input edge, timestamped in microseconds, seen when the tick counter was at tickCount.
+    // Returns the tick count to jump to, or NoJump if the rate correction is enough to pull the ticks in.
+    long Edge(unsigned long timestamp, unsigned long tickCount) {
+        if (_hasEdge) {
+            UpdatePeriod(timestamp - _lastEdge);
+        }
+        _lastEdge = timestamp;
+        _hasEdge = true;
+
+        if (!_locked) {
+            // Start counting from this edge
+            _locked = true;
+            _expectedTick = 0;
+            _tickLimit = _ticksPerPulse;
+            UpdateTickPeriod(0);
+            return 0;
+        }
+
+        _expectedTick += _ticksPerPulse;
+        _tickLimit = _expectedTick + _ticksPerPulse;
+
+        // Ticks still missing on this edge, the tick limit keeps the ticks from running ahead of the clock
+        long error = long(_expectedTick - tickCount);
+        if (error > long(_ticksPerPulse) || error < -long(_ticksPerPulse)) {
+            // Too far off to pull in smoothly, jump straight to the edge
+            UpdateTickPeriod(0);
+            return _expectedTick;
+        }
+        UpdateTickPeriod(error);
+        return NoJump;
+    }
+
+    bool IsLocked() { return _locked && _pulsePeriod > 0; }
+    unsigned long GetPulsePeriod() { return _pulsePeriod; } // Filtered edge period in microseconds
+    float GetTickPeriod() { return _tickPeriod; }           // Tick length in microseconds
+    unsigned long GetTickLimit() { return _tickLimit; }     // Ticks may not pass this before the next edge
+
+  private:
+    unsigned long _ticksPerPulse = 192;
+    unsigned long _lastEdge = 0;
+    unsigned long _pulsePeriod = 0;
+    unsigned long _expectedTick = 0;
+    unsigned long _tickLimit = 0;
+    float _tickPeriod = 0.0f;
+    bool _hasEdge = false;
+    bool _locked = false;
+
+    void UpdatePeriod(unsigned long interval) {
+        if (_pulsePeriod == 0 || interval > _pulsePeriod * 3 / 2 || interval < _pulsePeriod / 2) {
+            // First interval or a tempo jump, take it as it is
+            _pulsePeriod = interval;
+        } else {
+            // Smooth out the jitter while following tempo drift within a few edges
+            _pulsePeriod = long(_pulsePeriod) + (long(interval) - long(_pulsePeriod)) / 4;
+        }
+    }
+
+    // Spread the missing ticks over the next input period, catching up on half of them
+    void UpdateTickPeriod(long error) {
+        if (_pulsePeriod > 0) {
+            _tickPeriod = _pulsePeriod / (_ticksPerPulse + error / 2.0f);
+        }
+    }
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <Arduino.h>
+
+#define CV_RATE 1000        // CV inputs are read and applied this many times per second
+#define CV_FILTER_TIME 2.0f // Smoothing time constant in milliseconds
+#define CV_HYSTERESIS 4     // Input steps of noise held back around the last value
+
+// Conditioning of one CV input at the fixed CV rate. A one pole low pass, with its coefficient worked
+// out from the time constant and the rate so the smoothing does not depend on how often it is called
+// in real time, followed by a hysteresis that only lets the value move once the input has moved by
+// more than the noise around it.
+class CVInput {
+  public:
+    CVInput(float timeConstant = CV_FILTER_TIME, int hysteresis = CV_HYSTERESIS) : _hysteresis(hysteresis) {
+        SetTimeConstant(timeConstant);
+    }
+
+    void SetTimeConstant(float milliseconds) {
+        // Exact for a sampled RC filter, 1 - e^(-T/tau) of the way each step
+        float period = 1000.0f / CV_RATE;
+        _coefficient = 65536.0f * (1.0f - expf(-period / milliseconds));
+    }
+
+    void SetHysteresis(int hysteresis) { _hysteresis = hysteresis; }
+
+    // Start from a reading without smoothing towards it
+    void Reset(int32_t reading) {
+        _filtered = reading << 16;
+        _held = reading;
+    }
+
+    // Feed one reading, returns the conditioned value
+    int32_t Process(int32_t reading) {
+        // Q16 state, the product needs the extra bits
+        _filtered += ((int64_t)((reading << 16) - _filtered) * _coefficient) >> 16;
+        int32_t value = (_filtered + 0x8000) >> 16;
+        if (value > _held + _hysteresis) {
+            _held = value - _hysteresis;
+        } else if (value < _held - _hysteresis) {
+            _held = value + _hysteresis;
+        }
+        return _held;
+    }
+
+    int32_t GetValue() { return _held; }
+
+  private:
+    int32_t _coefficient; // Q16 share of the difference taken each step
+    int _hysteresis;
+    int32_t _filtered = 0;
+    int32_t _held = 0;
+};
@@ -1,4 +1,5 @@
 #include <Arduino.h>
+#include <TimerTC3.h>
 #include <TimerTCC0.h>
 // Rotary encoder setting
 #define ENCODER_OPTIMIZE_INTERRUPTS
@@ -9,7 +10,14 @@
 #include <Wire.h>
 
 // Load local libraries
+#include "audiodac.hpp"
 #include "boardIO.hpp"
+#include "clockcapture.hpp"
+#include "clocksync.hpp"
+#include "cvinput.hpp"
+#include "menu.hpp"
+#include "modmatrix.hpp"
+#include "gatetimer.hpp"
 #include "loadsave.hpp"
 #include "outputs.hpp"
 #include "pinouts.hpp"
@@ -24,6 +32,7 @@ int ADCOffset[2] = {23, 23};        // ADC offset for the channels
 
 // Configuration
 #define PPQN 192
+#define RANDOM_SEED 0 // Fixed seed for repeatable random patterns, 0 seeds from ADC noise at boot
 #define MAXDAC 4095
 
 #define OLED_ADDRESS 0x3C
@@ -38,12 +47,15 @@ Encoder encoder(ENC_PIN_1, ENC_PIN_2); // rotary encoder library setting
 float oldPosition = -999;              // rotary encoder library setting
 float newPosition = -999;              // rotary encoder library setting
 
-// Output objects
-Output outputs[NUM_OUTPUTS] = {
-    Output(1, OutputType::DigitalOut),
-    Output(2, OutputType::DigitalOut),
-    Output(3, OutputType::DACOut),
-    Output(4, OutputType::DACOut)};
+// Output objects, the gates come first and the DACs after them
+GateOutput gateOutputs[NUM_GATE_OUTS] = {
+    GateOutput(1),
+    GateOutput(2)};
+DACOutput dacOutputs[NUM_DAC_OUTS] = {
+    DACOutput(3),
+    DACOutput(4)};
+// Settings shared by every output, indexed by output number
+OutputCore *const outputs[NUM_OUTPUTS] = {&gateOutputs[0], &gateOutputs[1], &dacOutputs[0], &dacOutputs[1]};
 
 // ---- Global variables ----
 
@@ -85,7 +97,7 @@ enum CVTarget {
     Output4,
 };
 
-String CVTargetDescription[] = {
+char const *const CVTargetDescription[] = {
     "None",
     "Start/Stop",
     "Reset",
@@ -126,36 +138,49 @@ CVTarget pendingCVInputTarget[NUM_CV_INS] = {CVTarget::None, CVTarget::None};
 
 // ADC input offset and scale from calibration
 float offsetScale[NUM_CV_INS][2]; // [channel][0: offset, 1: scale]
-// CV target settings
-CVTarget CVInputTarget[NUM_CV_INS] = {CVTarget::None, CVTarget::None};
-int CVInputAttenuation[NUM_CV_INS] = {0, 0};
-int CVInputOffset[NUM_CV_INS] = {0, 0};
+// CV target settings, each input drives up to CV_ROUTES targets
+CVTarget CVInputTarget[NUM_CV_INS][CV_ROUTES] = {};
+int CVInputAttenuation[NUM_CV_INS][CV_ROUTES] = {};
+int CVInputOffset[NUM_CV_INS][CV_ROUTES] = {};
+ModMatrix modMatrix;
+static_assert(NUM_CV_INS * CV_ROUTES <= ModMatrix::MaxRoutes, "Every CV route needs a route in the matrix");
 
 // ADC input variables
-float channelADC[NUM_CV_INS], oldChannelADC[NUM_CV_INS];
+float channelADC[NUM_CV_INS];
+CVInput cvInputs[NUM_CV_INS];
+int cvTickCounter = 0; // Control ticks since the CV inputs were last handled
+static_assert(CONTROL_RATE % CV_RATE == 0, "The CV rate must divide the control rate");
 
 // BPM and clock settings
 unsigned int BPM = 120;
 unsigned int lastInternalBPM = 120;
 unsigned int const minBPM = 10;
 unsigned int const maxBPM = 300;
+unsigned int const minExternalBPM = 30; // Slower external clocks are taken as stopped
 
 // Play/Stop state
 bool masterState = true; // Track global play/stop state (true = playing, false = stopped)
 
 // Global tick counter
 volatile unsigned long tickCounter = 0;
+float tickPeriod = 0.0f; // Current tick length in microseconds
+uint8_t gatePulseStarts[NUM_GATE_OUTS] = {0, 0}; // Pulse starts already written to the gates
+// Gate widths as timer settings, ending on the tick until the first render works them out
+volatile uint32_t gateTimerCounts[NUM_GATE_OUTS] = {GATE_TIMER_TOO_LONG, GATE_TIMER_TOO_LONG};
+uint8_t gateScheduleVersion[NUM_GATE_OUTS] = {0, 0}; // Schedules the gate widths were worked out for
+float gateTickPeriod = 0.0f;                        // Tick length the gate widths were worked out for
 
 // External clock variables
-volatile unsigned long clockInterval = 0;
-volatile unsigned long lastClockInterruptTime = 0;
+ClockSync clockSync;
+volatile unsigned long lastClockInterruptTime = 0; // In microseconds
+unsigned long lastClockEdgeTime = 0;               // Hardware timestamp of the last edge
+volatile unsigned long tickLimit = 0;               // Ticks hold here until the next external edge
 volatile bool usingExternalClock = false;
 
-static int const dividerAmount = 7;
-int externalClockDividers[dividerAmount] = {1, 2, 4, 8, 16, 24, 48};
-String externalDividerDescription[dividerAmount] = {"x1", "/2 ", "/4", "/8", "/16", "24PPQN", "48PPQN"};
+static int const dividerAmount = 8;
+int externalClockDividers[dividerAmount] = {1, 2, 4, 8, 16, 24, 48, 96}; // Input pulses per beat, each must divide PPQN
+char const *const externalDividerDescription[dividerAmount] = {"x1", "/2 ", "/4", "/8", "/16", "24PPQN", "48PPQN", "96PPQN"};
 int externalDividerIndex = 0;
-volatile unsigned long externalTickCounter = 0;
 
 unsigned long lastDisplayUpdateTime = 0;
 const unsigned long DISPLAY_UPDATE_INTERVAL = 50; // Minimum 50ms between display updates
@@ -163,7 +188,6 @@ uint8_t frameSkip = 0;
 const uint8_t FRAME_SKIP_COUNT = 3; // Only update every 4th request
 
 // Menu variables
-int menuItems = 66;
 int menuItem = 3;
 bool switchState = 1;
 bool oldSwitchState = 1;
@@ -171,325 +195,44 @@ int menuMode = 0;                    // Menu mode for parameter editing
 bool displayRefresh = 1;             // Display refresh flag
 bool unsavedChanges = false;         // Unsaved changes flag
 int euclideanOutputSelect = 0;       // Euclidean rhythm output index
-int quantizerOutputSelect = 2;       // Quantizer output index
-int envelopeOutputSelect = 2;        // Envelope output index
+int quantizerOutputSelect = 0;       // Quantizer DAC output index
+int envelopeOutputSelect = 0;        // Envelope DAC output index
+int cvRouteSelect = 0;               // CV route index
 int saveSlot = 0;                    // Save slot index
 unsigned long lastEncoderUpdate = 0; // Last encoder update time
+// The level page has a level and offset item per DAC output, then their waveforms
+int const levelPageWaveformItem = 2 * NUM_DAC_OUTS;
 
 // Function prototypes
 void UpdateBPM(unsigned int);
+void SetTickPeriod(float);
 void SetTapTempo();
 void HandleIO();
 void SetMasterState(bool);
 void ToggleMasterState();
+void InitMenu();
 void HandleEncoderClick();
 void HandleEncoderPosition();
 void UpdateSpeedFactor();
 void HandleDisplay();
 void HandleExternalClock();
+void ClockEdge(unsigned long);
 void HandleCVInputs();
-void HandleCVTarget(int, float, CVTarget);
+void ApplyCVTarget(uint8_t, int32_t);
+void HandleCVTargets();
+void UpdateModRoutes();
+void CVGateChanged(int, bool);
 void HandleOutputs();
 void ClockPulse();
+void UpdateGates();
+void UpdateGateLengths();
+void RenderOutputs();
+void RenderAudio();
 void InitializeTimer();
 void UpdateParameters(LoadSaveParams);
 
 // ----------------------------------------------
 
-// Handle encoder button click
-void HandleEncoderClick() {
-    oldSwitchState = switchState;
-    switchState = digitalRead(ENCODER_SW);
-    if (switchState == 1 && oldSwitchState == 0) {
-        lastEncoderUpdate = millis();
-        displayRefresh = 1;
-        if (menuMode == 0) {
-            switch (menuItem) {
-            case 1: // Set BPM
-                menuMode = 1;
-                break;
-            case 2: // Toggle stopped state
-                ToggleMasterState();
-                break;
-            case 3: // Set div1
-                menuMode = 3;
-                break;
-            case 4: // Set div2
-                menuMode = 4;
-                break;
-            case 5: // Set div3
-                menuMode = 5;
-                break;
-            case 6: // Set div4
-                menuMode = 6;
-                break;
-            case 7: // External clock divider
-                menuMode = 7;
-                break;
-            case 8: // Toggle output 1
-                outputs[0].ToggleOutputState();
-                unsavedChanges = true;
-                break;
-            case 9: // Toggle output 2
-                outputs[1].ToggleOutputState();
-                unsavedChanges = true;
-                break;
-            case 10: // Toggle output 3
-                outputs[2].ToggleOutputState();
-                unsavedChanges = true;
-                break;
-            case 11: // Toggle output 4
-                outputs[3].ToggleOutputState();
-                unsavedChanges = true;
-                break;
-            case 12: // Set pulse probability for output 1
-                menuMode = 12;
-                break;
-            case 13: // Set pulse probability for output 2
-                menuMode = 13;
-                break;
-            case 14: // Set pulse probability for output 3
-                menuMode = 14;
-                break;
-            case 15: // Set pulse probability for output 4
-                menuMode = 15;
-                break;
-            case 16: // Select Euclidean rhythm output to edit
-                menuMode = 16;
-                break;
-            case 17: // Toggle Euclidean rhythm for output
-                outputs[euclideanOutputSelect].ToggleEuclidean();
-                unsavedChanges = true;
-                break;
-            case 18: // Set Euclidean rhythm step length
-                menuMode = 18;
-                break;
-            case 19: // Set Euclidean rhythm number of triggers
-                menuMode = 19;
-                break;
-            case 20: // Set Euclidean rhythm rotation
-                menuMode = 20;
-                break;
-            case 21: // Set euclidean padding
-                menuMode = 21;
-                break;
-            case 22: // Set swing amount for output 1
-                menuMode = 22;
-                break;
-            case 23: // Set swing every for output 1
-                menuMode = 23;
-                break;
-            case 24: // Set swing amount for output 2
-                menuMode = 24;
-                break;
-            case 25: // Set swing every for output 2
-                menuMode = 25;
-                break;
-            case 26: // Set swing amount for output 3
-                menuMode = 26;
-                break;
-            case 27: // Set swing every for output 3
-                menuMode = 27;
-                break;
-            case 28: // Set swing amount for output 4
-                menuMode = 28;
-                break;
-            case 29: // Set swing every for output 4
-                menuMode = 29;
-                break;
-            case 30: // Set phase shift for output 1
-                menuMode = 30;
-                break;
-            case 31: // Set phase shift for output 2
-                menuMode = 31;
-                break;
-            case 32: // Set phase shift for output 3
-                menuMode = 32;
-                break;
-            case 33: // Set phase shift for output 4
-                menuMode = 33;
-                break;
-            case 34: // Duty Cycle for output 1
-                menuMode = 34;
-                break;
-            case 35: // Duty Cycle for output 2
-                menuMode = 35;
-                break;
-            case 36: // Duty Cycle for output 3
-                menuMode = 36;
-                break;
-            case 37: // Duty Cycle for output 4
-                menuMode = 37;
-                break;
-            case 38: // Level control for output 3
-                menuMode = 38;
-                break;
-            case 39: // Level offset for output 3
-                menuMode = 39;
-                break;
-            case 40: // Level control for output 4
-                menuMode = 40;
-                break;
-            case 41: // Level offset for output 4
-                menuMode = 41;
-                break;
-            case 42: // Set Waveform type for output 3
-                menuMode = 42;
-                break;
-            case 43: // Set Waveform type for output 4
-                menuMode = 43;
-                break;
-            case 44: // Envelope output selection
-                menuMode = 44;
-                break;
-            case 45: // Envelope attack time
-                menuMode = 45;
-                break;
-            case 46: // Envelope decay time
-                menuMode = 46;
-                break;
-            case 47: // Envelope sustain level
-                menuMode = 47;
-                break;
-            case 48: // Envelope release time
-                menuMode = 48;
-                break;
-            case 49: // Envelope curve
-                menuMode = 49;
-                break;
-            case 50: // Envelope retrigger toggle
-                outputs[envelopeOutputSelect].ToggleRetrigger();
-                unsavedChanges = true;
-                break;
-            case 51: // CV Input 1 target
-                if (menuMode == 51) {
-                    pendingCVInputTarget[0] = CVInputTarget[0];
-                }
-                menuMode = 51;
-                break;
-            case 52: // CV Input 2 target
-                if (menuMode == 52) {
-                    pendingCVInputTarget[1] = CVInputTarget[1];
-                }
-                menuMode = 52;
-                break;
-            case 53: // CV Input 1 attenuation
-                menuMode = 53;
-                break;
-            case 54: // CV Input 1 offset
-                menuMode = 54;
-                break;
-            case 55: // CV Input 2 attenuation
-                menuMode = 55;
-                break;
-            case 56: // CV Input 2 offset
-                menuMode = 56;
-                break;
-            case 57: // Quantizer Output
-                menuMode = 57;
-                break;
-            case 58: // Quantizer Enable
-                outputs[quantizerOutputSelect].ToggleQuantizer();
-                unsavedChanges = true;
-                break;
-            case 59: // Quantizer root note
-                menuMode = 59;
-                break;
-            case 60: // Quantizer scale
-                menuMode = 60;
-                break;
-            case 61: // Quantizer octave shift
-                menuMode = 61;
-                break;
-            case 62: // Tap tempo
-                SetTapTempo();
-                break;
-            case 63: // Select save slot
-                menuMode = 63;
-                break;
-            case 64: { // Save settings
-                LoadSaveParams p;
-                p.valid = true;
-                p.BPM = BPM;
-                p.externalClockDivIdx = externalDividerIndex;
-                for (int i = 0; i < NUM_OUTPUTS; i++) {
-                    p.divIdx[i] = outputs[i].GetDividerIndex();
-                    p.dutyCycle[i] = outputs[i].GetDutyCycle();
-                    p.outputState[i] = outputs[i].GetOutputState();
-                    p.outputLevel[i] = outputs[i].GetLevel();
-                    p.outputOffset[i] = outputs[i].GetOffset();
-                    p.swingIdx[i] = outputs[i].GetSwingAmountIndex();
-                    p.swingEvery[i] = outputs[i].GetSwingEvery();
-                    p.pulseProbability[i] = outputs[i].GetPulseProbability();
-                    p.euclideanParams[i] = outputs[i].GetEuclideanParams();
-                    p.phaseShift[i] = outputs[i].GetPhase();
-                    p.waveformType[i] = int(outputs[i].GetWaveformType());
-                    p.envParams[i] = outputs[i].GetEnvelopeParams();
-                    p.quantizerParams[i] = outputs[i].GetQuantizerParams();
-                }
-                for (int i = 0; i < NUM_CV_INS; i++) {
-                    p.CVInputTarget[i] = CVInputTarget[i];
-                    p.CVInputAttenuation[i] = CVInputAttenuation[i];
-                    p.CVInputOffset[i] = CVInputOffset[i];
-                }
-
-                Save(p, saveSlot);
-                unsavedChanges = false;
-                display.clearDisplay(); // clear display
-                display.setTextSize(2);
-                display.setCursor(SCREEN_WIDTH / 2 - 30, SCREEN_HEIGHT / 2 - 16);
-                display.print("SAVED");
-                display.display();
-                unsigned long saveMessageStartTime = millis();
-                while (millis() - saveMessageStartTime < 1000) {
-                    HandleIO();
-                }
-                break;
-            }
-            case 65: { // Load from slot
-                LoadSaveParams p = Load(saveSlot);
-                UpdateParameters(p);
-                unsavedChanges = false;
-                display.clearDisplay(); // clear display
-                display.setTextSize(2);
-                display.setCursor(SCREEN_WIDTH / 2 - 30, SCREEN_HEIGHT / 2 - 16);
-                display.print("LOADED");
-                display.display();
-                unsigned long loadMessageStartTime = millis();
-                while (millis() - loadMessageStartTime < 1000) {
-                    HandleIO();
-                }
-                break;
-            }
-            case 66: { // Load default settings
-                LoadSaveParams p = LoadDefaultParams();
-                UpdateParameters(p);
-                unsavedChanges = false;
-                display.clearDisplay(); // clear display
-                display.setTextSize(2);
-                display.setCursor(SCREEN_WIDTH / 2 - 30, SCREEN_HEIGHT / 2 - 16);
-                display.print("LOADED");
-                display.display();
-                unsigned long loadMessageStartTime = millis();
-                while (millis() - loadMessageStartTime < 1000) {
-                    HandleIO();
-                }
-                break;
-            }
-            }
-        } else {
-            // Commit changes after exiting edit mode
-            if (menuMode == 51) {
-                CVInputTarget[0] = pendingCVInputTarget[0];
-            } else if (menuMode == 52) {
-                CVInputTarget[1] = pendingCVInputTarget[1];
-            }
-            // Exit edit mode
-            menuMode = 0;
-        }
-    }
-}
-
 // Calculate the speed of the encoder rotation
 float speedFactor;
 unsigned long lastEncoderTime = 0;
@@ -509,427 +252,336 @@ void UpdateSpeedFactor() {
     }
 }
 
-void HandleEncoderPosition() {
-    newPosition = encoder.read();
+// Menu item handlers. Each gets the item's position on its page, the adjusters also the direction the
+// encoder was turned in, which they scale by the rotation speed where the value has a wide range.
+void AdjustBPM(int, int direction) {
+    UpdateBPM(BPM + direction * speedFactor);
+}
 
-    if ((newPosition - 3) / 4 > oldPosition / 4) { // Decrease, turned counter-clockwise
-        UpdateSpeedFactor();
-        oldPosition = newPosition;
-        displayRefresh = 1;
-        lastEncoderUpdate = millis();
-        switch (menuMode) {
-        case 0:
-            menuItem = (menuItem - 1 < 1) ? menuItems : menuItem - 1;
-            break;
-        case 1: // Set BPM
-            UpdateBPM(BPM - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 3:
-        case 4:
-        case 5:
-        case 6: // Set div1, div2, div3, div4
-            outputs[menuMode - 3].SetDivider(outputs[menuMode - 3].GetDividerIndex() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 7: // External clock divider
-            externalDividerIndex = constrain(externalDividerIndex - speedFactor, 0, dividerAmount - 1);
-            unsavedChanges = true;
-            break;
-        case 12:
-        case 13:
-        case 14:
-        case 15: // Set Pulse Probability for outputs
-            outputs[menuMode - 12].SetPulseProbability(outputs[menuMode - 12].GetPulseProbability() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 16: // Set euclidean output to edit
-            euclideanOutputSelect = (euclideanOutputSelect - 1 < 0) ? NUM_OUTPUTS - 1 : euclideanOutputSelect - 1;
-            unsavedChanges = true;
-            break;
-        case 18: // Set Euclidean rhythm step length
-            outputs[euclideanOutputSelect].SetEuclideanSteps(outputs[euclideanOutputSelect].GetEuclideanSteps() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 19: // Set Euclidean rhythm number of triggers
-            outputs[euclideanOutputSelect].SetEuclideanTriggers(outputs[euclideanOutputSelect].GetEuclideanTriggers() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 20: // Set Euclidean rhythm rotation
-            outputs[euclideanOutputSelect].SetEuclideanRotation(outputs[euclideanOutputSelect].GetEuclideanRotation() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 21: // Set Euclidean padding
-            outputs[euclideanOutputSelect].SetEuclideanPadding(outputs[euclideanOutputSelect].GetEuclideanPadding() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 22:
-            outputs[0].SetSwingAmount(outputs[0].GetSwingAmountIndex() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 23:
-            outputs[0].SetSwingEvery(outputs[0].GetSwingEvery() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 24:
-            outputs[1].SetSwingAmount(outputs[1].GetSwingAmountIndex() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 25:
-            outputs[1].SetSwingEvery(outputs[1].GetSwingEvery() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 26:
-            outputs[2].SetSwingAmount(outputs[2].GetSwingAmountIndex() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 27:
-            outputs[2].SetSwingEvery(outputs[2].GetSwingEvery() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 28:
-            outputs[3].SetSwingAmount(outputs[3].GetSwingAmountIndex() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 29:
-            outputs[3].SetSwingEvery(outputs[3].GetSwingEvery() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 30:
-        case 31:
-        case 32:
-        case 33: // Set phase shift for outputs
-            outputs[menuMode - 30].SetPhase(outputs[menuMode - 30].GetPhase() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 34: // Duty Cycle for output 1
-            outputs[0].SetDutyCycle(outputs[0].GetDutyCycle() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 35: // Duty Cycle for output 2
-            outputs[1].SetDutyCycle(outputs[1].GetDutyCycle() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 36: // Duty Cycle for output 3
-            outputs[2].SetDutyCycle(outputs[2].GetDutyCycle() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 37: // Duty Cycle for output 4
-            outputs[3].SetDutyCycle(outputs[3].GetDutyCycle() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 38: // Set level for output 3
-            outputs[2].SetLevel(outputs[2].GetLevel() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 39: // Set offset for output 3
-            outputs[2].SetOffset(outputs[2].GetOffset() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 40: // Set level for output 4
-            outputs[3].SetLevel(outputs[3].GetLevel() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 41: // Set offset for output 4
-            outputs[3].SetOffset(outputs[3].GetOffset() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 42: // Set Output 3 waveform type
-            outputs[2].SetWaveformType(static_cast<WaveformType>((outputs[2].GetWaveformType() - 1 + WaveformTypeLength) % WaveformTypeLength));
-            unsavedChanges = true;
-            break;
-        case 43: // Set Output 4 waveform type
-            outputs[3].SetWaveformType(static_cast<WaveformType>((outputs[3].GetWaveformType() - 1 + WaveformTypeLength) % WaveformTypeLength));
-            unsavedChanges = true;
-            break;
-        case 44: // Envelope output selection
-            envelopeOutputSelect = (envelopeOutputSelect - 1 < 2) ? 3 : envelopeOutputSelect - 1;
-            unsavedChanges = true;
-            break;
-        case 45: // Envelope attack time
-            outputs[envelopeOutputSelect].SetAttack(outputs[envelopeOutputSelect].GetAttack() - speedFactor * 2);
-            unsavedChanges = true;
-            break;
-        case 46: // Envelope decay time
-            outputs[envelopeOutputSelect].SetDecay(outputs[envelopeOutputSelect].GetDecay() - speedFactor * 2);
-            unsavedChanges = true;
-            break;
-        case 47: // Envelope sustain level
-            outputs[envelopeOutputSelect].SetSustain(outputs[envelopeOutputSelect].GetSustain() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 48: // Envelope release time
-            outputs[envelopeOutputSelect].SetRelease(outputs[envelopeOutputSelect].GetRelease() - speedFactor * 2);
-            unsavedChanges = true;
-            break;
-        case 49: // Envelope curve
-            outputs[envelopeOutputSelect].SetCurve(outputs[envelopeOutputSelect].GetCurve() - speedFactor * 0.01);
-            unsavedChanges = true;
-            break;
-        case 51: { // CV Input 1 target
-            CVTarget tmp = static_cast<CVTarget>((pendingCVInputTarget[0] - 1 + CVTargetLength) % CVTargetLength);
-            if (tmp != pendingCVInputTarget[1] || tmp == CVTarget::None) {
-                pendingCVInputTarget[0] = tmp;
-            } else {
-                pendingCVInputTarget[0] = static_cast<CVTarget>((pendingCVInputTarget[0] - 2 + CVTargetLength) % CVTargetLength);
-            }
-            break;
-        }
-        case 52: { // CV Input 2 target
-            CVTarget tmp = static_cast<CVTarget>((pendingCVInputTarget[1] - 1 + CVTargetLength) % CVTargetLength);
-            if (tmp != pendingCVInputTarget[0] || tmp == CVTarget::None) {
-                pendingCVInputTarget[1] = tmp;
-            } else {
-                pendingCVInputTarget[1] = static_cast<CVTarget>((pendingCVInputTarget[1] - 2 + CVTargetLength) % CVTargetLength);
-            }
-            break;
-        }
-        case 53: // CV Input 1 attenuation
-            CVInputAttenuation[0] = constrain(CVInputAttenuation[0] - speedFactor, 0, 100);
-            break;
-        case 54: // CV Input 1 offset
-            CVInputOffset[0] = constrain(CVInputOffset[0] - speedFactor, 0, 100);
-            break;
-        case 55: // CV Input 2 attenuation
-            CVInputAttenuation[1] = constrain(CVInputAttenuation[1] - speedFactor, 0, 100);
-            break;
-        case 56: // CV Input 2 offset
-            CVInputOffset[1] = constrain(CVInputOffset[1] - speedFactor, 0, 100);
-            break;
-        case 57: // Quantizer output
-            quantizerOutputSelect = (quantizerOutputSelect - 1 < 2) ? 3 : quantizerOutputSelect - 1;
-            unsavedChanges = true;
-            break;
-        case 59: // Quantizer root note
-            outputs[quantizerOutputSelect].SetQuantizerNoteIndex(outputs[quantizerOutputSelect].GetQuantizerNoteIndex() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 60: // Quantizer scale
-            outputs[quantizerOutputSelect].SetQuantizerScaleIndex(outputs[quantizerOutputSelect].GetQuantizerScaleIndex() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 61: // Quantizer octave shift
-            outputs[quantizerOutputSelect].SetQuantizerOctaveShift(outputs[quantizerOutputSelect].GetQuantizerOctaveShift() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 63: // Select save slot
-            saveSlot = (saveSlot - 1 < 0) ? NUM_SLOTS : saveSlot - 1;
-            break;
-        }
-    } else if ((newPosition + 3) / 4 < oldPosition / 4) { // Increase, turned clockwise
-        UpdateSpeedFactor();
-        oldPosition = newPosition;
-        displayRefresh = 1;
-        lastEncoderUpdate = millis();
-        switch (menuMode) {
-        case 0:
-            menuItem = (menuItem + 1 > menuItems) ? 1 : menuItem + 1;
-            break;
-        case 1: // Set BPM
-            UpdateBPM(BPM + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 3:
-        case 4:
-        case 5:
-        case 6: // Set div1, div2, div3, div4
-            outputs[menuMode - 3].SetDivider(outputs[menuMode - 3].GetDividerIndex() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 7: // External clock divider
-            externalDividerIndex = constrain(externalDividerIndex + speedFactor, 0, dividerAmount - 1);
-            unsavedChanges = true;
-            break;
-        case 12:
-        case 13:
-        case 14:
-        case 15: // Set Pulse Probability for outputs
-            outputs[menuMode - 12].SetPulseProbability(outputs[menuMode - 12].GetPulseProbability() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 16: // Set euclidean output to edit
-            euclideanOutputSelect = (euclideanOutputSelect + 1 > NUM_OUTPUTS - 1) ? 0 : euclideanOutputSelect + 1;
-            unsavedChanges = true;
-            break;
-        case 18: // Set Euclidean rhythm step length
-            outputs[euclideanOutputSelect].SetEuclideanSteps(outputs[euclideanOutputSelect].GetEuclideanSteps() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 19: // Set Euclidean rhythm number of triggers
-            outputs[euclideanOutputSelect].SetEuclideanTriggers(outputs[euclideanOutputSelect].GetEuclideanTriggers() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 20: // Set Euclidean rhythm rotation
-            outputs[euclideanOutputSelect].SetEuclideanRotation(outputs[euclideanOutputSelect].GetEuclideanRotation() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 21: // Set Euclidean padding
-            outputs[euclideanOutputSelect].SetEuclideanPadding(outputs[euclideanOutputSelect].GetEuclideanPadding() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 22:
-            outputs[0].SetSwingAmount(outputs[0].GetSwingAmountIndex() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 23:
-            outputs[0].SetSwingEvery(outputs[0].GetSwingEvery() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 24:
-            outputs[1].SetSwingAmount(outputs[1].GetSwingAmountIndex() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 25:
-            outputs[1].SetSwingEvery(outputs[1].GetSwingEvery() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 26:
-            outputs[2].SetSwingAmount(outputs[2].GetSwingAmountIndex() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 27:
-            outputs[2].SetSwingEvery(outputs[2].GetSwingEvery() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 28:
-            outputs[3].SetSwingAmount(outputs[3].GetSwingAmountIndex() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 29:
-            outputs[3].SetSwingEvery(outputs[3].GetSwingEvery() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 30:
-        case 31:
-        case 32:
-        case 33: // Set phase shift for outputs
-            outputs[menuMode - 30].SetPhase(outputs[menuMode - 30].GetPhase() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 34: // Duty Cycle for output 1
-            outputs[0].SetDutyCycle(outputs[0].GetDutyCycle() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 35: // Duty Cycle for output 2
-            outputs[1].SetDutyCycle(outputs[1].GetDutyCycle() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 36: // Duty Cycle for output 3
-            outputs[2].SetDutyCycle(outputs[2].GetDutyCycle() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 37: // Duty Cycle for output 4
-            outputs[3].SetDutyCycle(outputs[3].GetDutyCycle() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 38: // Set level for output 3
-            outputs[2].SetLevel(outputs[2].GetLevel() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 39: // Set offset for output 3
-            outputs[2].SetOffset(outputs[2].GetOffset() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 40: // Set level for output 4
-            outputs[3].SetLevel(outputs[3].GetLevel() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 41: // Set offset for output 4
-            outputs[3].SetOffset(outputs[3].GetOffset() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 42: // Set Output 3 waveform type
-            outputs[2].SetWaveformType(static_cast<WaveformType>((outputs[2].GetWaveformType() + 1) % WaveformTypeLength));
-            unsavedChanges = true;
-            break;
-        case 43: // Set Output 4 waveform type
-            outputs[3].SetWaveformType(static_cast<WaveformType>((outputs[3].GetWaveformType() + 1) % WaveformTypeLength));
-            unsavedChanges = true;
-            break;
-        case 44: // Envelope output selection
-            envelopeOutputSelect = (envelopeOutputSelect + 1 > 3) ? 2 : envelopeOutputSelect + 1;
-            unsavedChanges = true;
-            break;
-        case 45: // Envelope attack time
-            outputs[envelopeOutputSelect].SetAttack(outputs[envelopeOutputSelect].GetAttack() + speedFactor * 2);
-            unsavedChanges = true;
-            break;
-        case 46: // Envelope decay time
-            outputs[envelopeOutputSelect].SetDecay(outputs[envelopeOutputSelect].GetDecay() + speedFactor * 2);
-            unsavedChanges = true;
-            break;
-        case 47: // Envelope sustain level
-            outputs[envelopeOutputSelect].SetSustain(outputs[envelopeOutputSelect].GetSustain() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 48: // Envelope release time
-            outputs[envelopeOutputSelect].SetRelease(outputs[envelopeOutputSelect].GetRelease() + speedFactor * 2);
-            unsavedChanges = true;
-            break;
-        case 49: // Envelope curve
-            outputs[envelopeOutputSelect].SetCurve(outputs[envelopeOutputSelect].GetCurve() + speedFactor * 0.01);
-            unsavedChanges = true;
-            break;
-        case 51: { // CV Input 1 target
-            CVTarget tmp = static_cast<CVTarget>((pendingCVInputTarget[0] + 1) % CVTargetLength);
-            if (tmp != pendingCVInputTarget[1] || tmp == CVTarget::None) {
-                pendingCVInputTarget[0] = tmp;
-            } else {
-                pendingCVInputTarget[0] = static_cast<CVTarget>((pendingCVInputTarget[0] + 2) % CVTargetLength);
-            }
-            break;
-        }
-        case 52: { // CV Input 2 target
-            CVTarget tmp = static_cast<CVTarget>((pendingCVInputTarget[1] + 1) % CVTargetLength);
-            if (tmp != pendingCVInputTarget[0] || tmp == CVTarget::None) {
-                pendingCVInputTarget[1] = tmp;
-            } else {
-                pendingCVInputTarget[1] = static_cast<CVTarget>((pendingCVInputTarget[1] + 2) % CVTargetLength);
+void SelectMasterState(int) {
+    ToggleMasterState();
+}
+
+void AdjustDivider(int index, int direction) {
+    outputs[index]->SetDivider(outputs[index]->GetDividerIndex() + direction * speedFactor);
+}
+
+// The external clock divider follows the four output dividers on their page
+void AdjustExternalDivider(int, int direction) {
+    externalDividerIndex = constrain(externalDividerIndex + direction * speedFactor, 0, dividerAmount - 1);
+}
+
+void SelectOutputState(int index) {
+    outputs[index]->ToggleOutputState();
+}
+
+void AdjustPulseProbability(int index, int direction) {
+    outputs[index]->SetPulseProbability(outputs[index]->GetPulseProbability() + direction * speedFactor);
+}
+
+void AdjustEuclideanOutput(int, int direction) {
+    euclideanOutputSelect = (euclideanOutputSelect + direction + NUM_OUTPUTS) % NUM_OUTPUTS;
+}
+
+void SelectEuclidean(int) {
+    outputs[euclideanOutputSelect]->ToggleEuclidean();
+}
+
+void AdjustEuclideanSteps(int, int direction) {
+    outputs[euclideanOutputSelect]->SetEuclideanSteps(outputs[euclideanOutputSelect]->GetEuclideanSteps() + direction * speedFactor);
+}
+
+void AdjustEuclideanTriggers(int, int direction) {
+    outputs[euclideanOutputSelect]->SetEuclideanTriggers(outputs[euclideanOutputSelect]->GetEuclideanTriggers() + direction * speedFactor);
+}
+
+void AdjustEuclideanRotation(int, int direction) {
+    outputs[euclideanOutputSelect]->SetEuclideanRotation(outputs[euclideanOutputSelect]->GetEuclideanRotation() + direction * speedFactor);
+}
+
+void AdjustEuclideanPadding(int, int direction) {
+    outputs[euclideanOutputSelect]->SetEuclideanPadding(outputs[euclideanOutputSelect]->GetEuclideanPadding() + direction * speedFactor);
+}
+
+// Swing amount and swing every alternate on their page, one pair per output
+void AdjustSwingAmount(int index, int direction) {
+    outputs[index / 2]->SetSwingAmount(outputs[index / 2]->GetSwingAmountIndex() + direction * speedFactor);
+}
+
+void AdjustSwingEvery(int index, int direction) {
+    outputs[index / 2]->SetSwingEvery(outputs[index / 2]->GetSwingEvery() + direction * speedFactor);
+}
+
+void AdjustPhase(int index, int direction) {
+    outputs[index]->SetPhase(outputs[index]->GetPhase() + direction * speedFactor);
+}
+
+void AdjustDutyCycle(int index, int direction) {
+    outputs[index]->SetDutyCycle(outputs[index]->GetDutyCycle() + direction * speedFactor);
+}
+
+// Level and offset alternate for outputs 3 and 4, followed by their waveforms at levelPageWaveformItem
+void AdjustLevel(int index, int direction) {
+    dacOutputs[index / 2].SetLevel(dacOutputs[index / 2].GetLevel() + direction * speedFactor);
+}
+
+void AdjustOffset(int index, int direction) {
+    dacOutputs[index / 2].SetOffset(dacOutputs[index / 2].GetOffset() + direction * speedFactor);
+}
+
+void AdjustWaveform(int index, int direction) {
+    DACOutput &output = dacOutputs[index - levelPageWaveformItem];
+    int amount = output.GetWaveformTypeAmount();
+    output.SetWaveformType(static_cast<WaveformType>((output.GetWaveformType() + direction + amount) % amount));
+}
+
+// The envelope, quantizer and CV pages only apply to the DAC outputs 3 and 4
+void AdjustEnvelopeOutput(int, int) {
+    envelopeOutputSelect = (envelopeOutputSelect + 1) % NUM_DAC_OUTS;
+}
+
+void AdjustAttack(int, int direction) {
+    dacOutputs[envelopeOutputSelect].SetAttack(dacOutputs[envelopeOutputSelect].GetAttack() + direction * speedFactor * 2);
+}
+
+void AdjustDecay(int, int direction) {
+    dacOutputs[envelopeOutputSelect].SetDecay(dacOutputs[envelopeOutputSelect].GetDecay() + direction * speedFactor * 2);
+}
+
+void AdjustSustain(int, int direction) {
+    dacOutputs[envelopeOutputSelect].SetSustain(dacOutputs[envelopeOutputSelect].GetSustain() + direction * speedFactor);
+}
+
+void AdjustRelease(int, int direction) {
+    dacOutputs[envelopeOutputSelect].SetRelease(dacOutputs[envelopeOutputSelect].GetRelease() + direction * speedFactor * 2);
+}
+
+void AdjustCurve(int, int direction) {
+    dacOutputs[envelopeOutputSelect].SetCurve(dacOutputs[envelopeOutputSelect].GetCurve() + direction * speedFactor * 0.01);
+}
+
+void SelectRetrigger(int) {
+    dacOutputs[envelopeOutputSelect].ToggleRetrigger();
+}
+
+// Every CV page edits one route of both inputs
+void AdjustCVRoute(int, int direction) {
+    cvRouteSelect = (cvRouteSelect + direction + CV_ROUTES) % CV_ROUTES;
+}
+
+// The CV targets are edited on a copy and only take effect when the edit is closed. A target can only
+// be driven by one route, the ones taken by the other routes are skipped.
+void EnterCVTarget(int index) {
+    pendingCVInputTarget[index - 1] = CVInputTarget[index - 1][cvRouteSelect];
+}
+
+bool IsCVTargetTaken(CVTarget target, int input, int route) {
+    for (int i = 0; i < NUM_CV_INS; i++) {
+        for (int j = 0; j < CV_ROUTES; j++) {
+            if ((i != input || j != route) && CVInputTarget[i][j] == target) {
+                return true;
             }
-            break;
         }
-        case 53: // CV Input 1 attenuation
-            CVInputAttenuation[0] = constrain(CVInputAttenuation[0] + speedFactor, 0, 100);
-            break;
-        case 54: // CV Input 1 offset
-            CVInputOffset[0] = constrain(CVInputOffset[0] + speedFactor, 0, 100);
-            break;
-        case 55: // CV Input 2 attenuation
-            CVInputAttenuation[1] = constrain(CVInputAttenuation[1] + speedFactor, 0, 100);
-            break;
-        case 56: // CV Input 2 offset
-            CVInputOffset[1] = constrain(CVInputOffset[1] + speedFactor, 0, 100);
-            break;
-        case 57: // Quantizer output
-            quantizerOutputSelect = (quantizerOutputSelect + 1 > 3) ? 2 : quantizerOutputSelect + 1;
-            unsavedChanges = true;
-            break;
-        case 59: // Quantizer root note
-            outputs[quantizerOutputSelect].SetQuantizerNoteIndex(outputs[quantizerOutputSelect].GetQuantizerNoteIndex() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 60: // Quantizer scale
-            outputs[quantizerOutputSelect].SetQuantizerScaleIndex(outputs[quantizerOutputSelect].GetQuantizerScaleIndex() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 61: // Quantizer octave shift
-            outputs[quantizerOutputSelect].SetQuantizerOctaveShift(outputs[quantizerOutputSelect].GetQuantizerOctaveShift() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 63: // Select save slot
-            saveSlot = (saveSlot + 1 > NUM_SLOTS) ? 0 : saveSlot + 1;
-            break;
+    }
+    return false;
+}
+
+void AdjustCVTarget(int index, int direction) {
+    int input = index - 1;
+    CVTarget target = pendingCVInputTarget[input];
+    do {
+        target = static_cast<CVTarget>((target + direction + CVTargetLength) % CVTargetLength);
+    } while (target != CVTarget::None && IsCVTargetTaken(target, input, cvRouteSelect));
+    pendingCVInputTarget[input] = target;
+}
+
+void ExitCVTarget(int index) {
+    CVInputTarget[index - 1][cvRouteSelect] = pendingCVInputTarget[index - 1];
+    UpdateModRoutes();
+}
+
+// Attenuation and offset alternate after the targets, one pair per input
+void AdjustCVAttenuation(int index, int direction) {
+    int input = (index - 1 - NUM_CV_INS) / 2;
+    CVInputAttenuation[input][cvRouteSelect] = constrain(CVInputAttenuation[input][cvRouteSelect] + direction * speedFactor, 0, 100);
+    UpdateModRoutes();
+}
+
+void AdjustCVOffset(int index, int direction) {
+    int input = (index - 1 - NUM_CV_INS) / 2;
+    CVInputOffset[input][cvRouteSelect] = constrain(CVInputOffset[input][cvRouteSelect] + direction * speedFactor, 0, 100);
+    UpdateModRoutes();
+}
+
+void AdjustQuantizerOutput(int, int) {
+    quantizerOutputSelect = (quantizerOutputSelect + 1) % NUM_DAC_OUTS;
+}
+
+void SelectQuantizer(int) {
+    dacOutputs[quantizerOutputSelect].ToggleQuantizer();
+}
+
+void AdjustQuantizerNote(int, int direction) {
+    dacOutputs[quantizerOutputSelect].SetQuantizerNoteIndex(dacOutputs[quantizerOutputSelect].GetQuantizerNoteIndex() + direction * speedFactor);
+}
+
+void AdjustQuantizerScale(int, int direction) {
+    dacOutputs[quantizerOutputSelect].SetQuantizerScaleIndex(dacOutputs[quantizerOutputSelect].GetQuantizerScaleIndex() + direction * speedFactor);
+}
+
+void AdjustQuantizerOctave(int, int direction) {
+    dacOutputs[quantizerOutputSelect].SetQuantizerOctaveShift(dacOutputs[quantizerOutputSelect].GetQuantizerOctaveShift() + direction * speedFactor);
+}
+
+void SelectTapTempo(int) {
+    SetTapTempo();
+}
+
+void AdjustSaveSlot(int, int direction) {
+    saveSlot = (saveSlot + direction + NUM_SLOTS + 1) % (NUM_SLOTS + 1);
+}
+
+// Show a message for a second, the inputs and outputs keep running meanwhile
+void ShowMessage(const char *message) {
+    display.clearDisplay(); // clear display
+    display.setTextSize(2);
+    display.setCursor(SCREEN_WIDTH / 2 - 30, SCREEN_HEIGHT / 2 - 16);
+    display.print(message);
+    UpdateDisplay();
+    unsigned long messageStartTime = millis();
+    while (millis() - messageStartTime < 1000) {
+        HandleIO();
+    }
+}
+
+void SelectSave(int) {
+    LoadSaveParams p = LoadDefaultParams(); // Fills the settings the gates do not have
+    p.valid = true;
+    p.BPM = BPM;
+    p.externalClockDivIdx = externalDividerIndex;
+    for (int i = 0; i < NUM_OUTPUTS; i++) {
+        p.divIdx[i] = outputs[i]->GetDividerIndex();
+        p.dutyCycle[i] = outputs[i]->GetDutyCycle();
+        p.outputState[i] = outputs[i]->GetOutputState();
+        p.swingIdx[i] = outputs[i]->GetSwingAmountIndex();
+        p.swingEvery[i] = outputs[i]->GetSwingEvery();
+        p.pulseProbability[i] = outputs[i]->GetPulseProbability();
+        p.euclideanParams[i] = outputs[i]->GetEuclideanParams();
+        p.phaseShift[i] = outputs[i]->GetPhase();
+    }
+    // Only the DAC outputs have levels, waveforms, envelopes and quantizers, the gates keep the defaults
+    for (int i = 0; i < NUM_DAC_OUTS; i++) {
+        p.outputLevel[NUM_GATE_OUTS + i] = dacOutputs[i].GetLevel();
+        p.outputOffset[NUM_GATE_OUTS + i] = dacOutputs[i].GetOffset();
+        p.waveformType[NUM_GATE_OUTS + i] = int(dacOutputs[i].GetWaveformType());
+        p.envParams[NUM_GATE_OUTS + i] = dacOutputs[i].GetEnvelopeParams();
+        p.quantizerParams[NUM_GATE_OUTS + i] = dacOutputs[i].GetQuantizerParams();
+    }
+    for (int i = 0; i < NUM_CV_INS; i++) {
+        for (int j = 0; j < CV_ROUTES; j++) {
+            p.CVInputTarget[i][j] = CVInputTarget[i][j];
+            p.CVInputAttenuation[i][j] = CVInputAttenuation[i][j];
+            p.CVInputOffset[i][j] = CVInputOffset[i][j];
         }
     }
+
+    Save(p, saveSlot);
+    unsavedChanges = false;
+    ShowMessage("SAVED");
+}
+
+void SelectLoad(int) {
+    UpdateParameters(Load(saveSlot));
+    unsavedChanges = false;
+    ShowMessage("LOADED");
+}
+
+void SelectLoadDefaults(int) {
+    UpdateParameters(LoadDefaultParams());
+    unsavedChanges = false;
+    ShowMessage("LOADED");
 }
 
+// Every menu item in order, the pages below group consecutive items. Items with an adjuster open
+// an edit mode on click, the others run their select handler right away.
+constexpr MenuEntry menuEntries[] = {
+    {AdjustBPM, nullptr, nullptr, nullptr, true},
+    {nullptr, SelectMasterState, nullptr, nullptr, false},
+    {AdjustDivider, nullptr, nullptr, nullptr, true},
+    {AdjustDivider, nullptr, nullptr, nullptr, true},
+    {AdjustDivider, nullptr, nullptr, nullptr, true},
+    {AdjustDivider, nullptr, nullptr, nullptr, true},
+    {AdjustExternalDivider, nullptr, nullptr, nullptr, true},
+    {nullptr, SelectOutputState, nullptr, nullptr, true},
+    {nullptr, SelectOutputState, nullptr, nullptr, true},
+    {nullptr, SelectOutputState, nullptr, nullptr, true},
+    {nullptr, SelectOutputState, nullptr, nullptr, true},
+    {AdjustPulseProbability, nullptr, nullptr, nullptr, true},
+    {AdjustPulseProbability, nullptr, nullptr, nullptr, true},
+    {AdjustPulseProbability, nullptr, nullptr, nullptr, true},
+    {AdjustPulseProbability, nullptr, nullptr, nullptr, true},
+    {AdjustEuclideanOutput, nullptr, nullptr, nullptr, true},
+    {nullptr, SelectEuclidean, nullptr, nullptr, true},
+    {AdjustEuclideanSteps, nullptr, nullptr, nullptr, true},
+    {AdjustEuclideanTriggers, nullptr, nullptr, nullptr, true},
+    {AdjustEuclideanRotation, nullptr, nullptr, nullptr, true},
+    {AdjustEuclideanPadding, nullptr, nullptr, nullptr, true},
+    {AdjustSwingAmount, nullptr, nullptr, nullptr, true},
+    {AdjustSwingEvery, nullptr, nullptr, nullptr, true},
+    {AdjustSwingAmount, nullptr, nullptr, nullptr, true},
+    {AdjustSwingEvery, nullptr, nullptr, nullptr, true},
+    {AdjustSwingAmount, nullptr, nullptr, nullptr, true},
+    {AdjustSwingEvery, nullptr, nullptr, nullptr, true},
+    {AdjustSwingAmount, nullptr, nullptr, nullptr, true},
+    {AdjustSwingEvery, nullptr, nullptr, nullptr, true},
+    {AdjustPhase, nullptr, nullptr, nullptr, true},
+    {AdjustPhase, nullptr, nullptr, nullptr, true},
+    {AdjustPhase, nullptr, nullptr, nullptr, true},
+    {AdjustPhase, nullptr, nullptr, nullptr, true},
+    {AdjustDutyCycle, nullptr, nullptr, nullptr, true},
+    {AdjustDutyCycle, nullptr, nullptr, nullptr, true},
+    {AdjustDutyCycle, nullptr, nullptr, nullptr, true},
+    {AdjustDutyCycle, nullptr, nullptr, nullptr, true},
+    {AdjustLevel, nullptr, nullptr, nullptr, true},
+    {AdjustOffset, nullptr, nullptr, nullptr, true},
+    {AdjustLevel, nullptr, nullptr, nullptr, true},
+    {AdjustOffset, nullptr, nullptr, nullptr, true},
+    {AdjustWaveform, nullptr, nullptr, nullptr, true},
+    {AdjustWaveform, nullptr, nullptr, nullptr, true},
+    {AdjustEnvelopeOutput, nullptr, nullptr, nullptr, true},
+    {AdjustAttack, nullptr, nullptr, nullptr, true},
+    {AdjustDecay, nullptr, nullptr, nullptr, true},
+    {AdjustSustain, nullptr, nullptr, nullptr, true},
+    {AdjustRelease, nullptr, nullptr, nullptr, true},
+    {AdjustCurve, nullptr, nullptr, nullptr, true},
+    {nullptr, SelectRetrigger, nullptr, nullptr, true},
+    {AdjustCVRoute, nullptr, nullptr, nullptr, false},
+    {AdjustCVTarget, nullptr, EnterCVTarget, ExitCVTarget, false},
+    {AdjustCVTarget, nullptr, EnterCVTarget, ExitCVTarget, false},
+    {AdjustCVAttenuation, nullptr, nullptr, nullptr, false},
+    {AdjustCVOffset, nullptr, nullptr, nullptr, false},
+    {AdjustCVAttenuation, nullptr, nullptr, nullptr, false},
+    {AdjustCVOffset, nullptr, nullptr, nullptr, false},
+    {AdjustQuantizerOutput, nullptr, nullptr, nullptr, true},
+    {nullptr, SelectQuantizer, nullptr, nullptr, true},
+    {AdjustQuantizerNote, nullptr, nullptr, nullptr, true},
+    {AdjustQuantizerScale, nullptr, nullptr, nullptr, true},
+    {AdjustQuantizerOctave, nullptr, nullptr, nullptr, true},
+    {nullptr, SelectTapTempo, nullptr, nullptr, false},
+    {AdjustSaveSlot, nullptr, nullptr, nullptr, false},
+    {nullptr, SelectSave, nullptr, nullptr, false},
+    {nullptr, SelectLoad, nullptr, nullptr, false},
+    {nullptr, SelectLoadDefaults, nullptr, nullptr, false},
+};
+int const menuItems = sizeof(menuEntries) / sizeof(menuEntries[0]);
+
 // Redraw the display and show unsaved changes indicator
 void RedrawDisplay() {
     // If there are unsaved changes, display a circle at the top left corner
     if (unsavedChanges) {
         display.fillCircle(1, 1, 1, WHITE);
     }
-    display.display();
+    UpdateDisplay();
     displayRefresh = 0;
 }
 
@@ -947,659 +599,734 @@ void MenuHeader(const char *header) {
     display.setTextSize(1);
     int headerLength = (strlen(header) * 6) + 24; // Sum of the length of the header and the "- " sides
     display.setCursor((SCREEN_WIDTH - headerLength) / 2, 1);
-    display.println("- " + String(header) + " -");
+    display.print("- ");
+    display.print(header);
+    display.println(" -");
 }
 
-// Handle display drawing
-void HandleDisplay() {
-    // Only refresh the display at a reasonable rate
-    unsigned long currentTime = millis();
-
-    if (displayRefresh && (currentTime - lastDisplayUpdateTime >= DISPLAY_UPDATE_INTERVAL)) {
-        lastDisplayUpdateTime = currentTime;
-
-        display.clearDisplay();
-        MenuIndicator();
-
-        // Draw the menu
-        int menuIdx = 1;
-        int itemAmount = 2;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            String s = String(BPM) + "BPM";
-            display.setTextSize(3);
-            // Centralize the BPM display
-            display.setCursor((SCREEN_WIDTH - (s.length() * 18)) / 2, 0);
-            display.print(s);
-            if (usingExternalClock) {
-                display.setTextSize(1);
-                display.setCursor(120, 24);
-                display.print("E");
-            }
-            // Draw selection triangle
-            if (menuMode == 0 && menuItem == 1) {
-                display.drawTriangle(2, 6, 2, 14, 6, 10, 1);
-            } else if (menuMode == menuItem) {
-                display.fillTriangle(2, 6, 2, 14, 6, 10, 1);
-            }
-
-            if (menuMode >= 0 && menuMode <= 2) {
-                display.setTextSize(2);
-                display.setCursor(44, 27);
-                if (menuItem == 2) {
-                    display.drawLine(43, 42, 88, 42, 1);
-                }
-                if (!masterState) {
-                    display.fillRoundRect(23, 26, 17, 17, 2, 1);
-                    display.print("STOP");
-                } else {
-                    display.fillTriangle(23, 26, 23, 42, 39, 34, 1);
-                    display.print("PLAY");
-                }
-            }
-
-            // Show a box to each output showing if it's enabled
-            display.setTextSize(1);
-            for (int i = 0; i < NUM_OUTPUTS; i++) {
-                if (outputs[i].GetOutputState()) {
-                    display.fillRect((i * 30) + 14, 46, 9, 9, WHITE);
-                    display.setCursor((i * 30) + 16, 47);
-                    display.setTextColor(BLACK);
-                    display.print(i + 1);
-                } else {
-                    display.drawRect((i * 30) + 14, 46, 9, 9, WHITE);
-                    display.setCursor((i * 30) + 16, 47);
-                    display.setTextColor(WHITE);
-                    display.print(i + 1);
-                }
-                display.setTextColor(WHITE);
-                String s = outputs[i].GetDividerDescription();
-                display.setCursor((i * 30) + 13 + (6 - (s.length() * 3)), 56);
-                display.print(s);
-            }
-            RedrawDisplay();
-            return;
-        }
-
-        // Clock dividers menu
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 5;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("CLOCK DIVIDERS");
-            int yPosition = 20;
-            for (int i = 0; i < NUM_OUTPUTS; i++) {
-                display.setCursor(10, yPosition);
-                display.print("OUTPUT " + String(i + 1) + ":");
-                display.setCursor(84, yPosition);
-                display.print(outputs[i].GetDividerDescription());
-                if (menuItem == i + menuIdx) {
-                    if (menuMode == 0) {
-                        display.drawTriangle(1, 19 + (i * 9), 1, 27 + (i * 9), 5, 23 + (i * 9), 1);
-                    } else if (menuMode == i + menuIdx) {
-                        display.fillTriangle(1, 19 + (i * 9), 1, 27 + (i * 9), 5, 23 + (i * 9), 1);
-                    }
-                }
-                yPosition += 9;
-            }
-            // For external clock divider
-            display.setCursor(10, yPosition);
-            display.print("EXT. DIV:");
-            display.setCursor(84, yPosition);
-            display.print(externalDividerDescription[externalDividerIndex]);
-            if (menuItem == 7) {
-                if (menuMode == 0) {
-                    display.drawTriangle(1, 19 + (NUM_OUTPUTS * 9), 1, 27 + (NUM_OUTPUTS * 9), 5, 23 + (NUM_OUTPUTS * 9), 1);
-                } else if (menuMode == 7) {
-                    display.fillTriangle(1, 19 + (NUM_OUTPUTS * 9), 1, 27 + (NUM_OUTPUTS * 9), 5, 23 + (NUM_OUTPUTS * 9), 1);
-                }
-            }
-
-            RedrawDisplay();
-            return;
-        }
-
-        // Clock outputs state menu
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 4;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("OUTPUT STATE");
-            int yPosition = 20;
-            for (int i = 0; i < NUM_OUTPUTS; i++) {
-                display.setCursor(10, yPosition);
-                display.print("OUTPUT " + String(i + 1) + ":");
-                display.setCursor(70, yPosition);
-                display.print(outputs[i].GetOutputState() ? "ON" : "OFF");
-                if (menuItem == i + menuIdx) {
-                    if (menuMode == 0) {
-                        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    } else if (menuMode == i + menuIdx) {
-                        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    }
-                }
-                yPosition += 9;
-            }
-            RedrawDisplay();
-            return;
-        }
+// BPM, play state and an overview of the outputs
+void DrawMainPage(int, int) {
+    char s[DESCRIPTION_LENGTH];
+    snprintf(s, sizeof(s), "%uBPM", BPM);
+    display.setTextSize(3);
+    // Centralize the BPM display
+    display.setCursor((SCREEN_WIDTH - (strlen(s) * 18)) / 2, 0);
+    display.print(s);
+    if (usingExternalClock) {
+        display.setTextSize(1);
+        display.setCursor(120, 24);
+        display.print("E");
+    }
+    // Draw selection triangle
+    if (menuMode == 0 && menuItem == 1) {
+        display.drawTriangle(2, 6, 2, 14, 6, 10, 1);
+    } else if (menuMode == menuItem) {
+        display.fillTriangle(2, 6, 2, 14, 6, 10, 1);
+    }
 
-        // Pulse Probability menu
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 4;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("PROBABILITY");
-            int yPosition = 20;
-            for (int i = 0; i < NUM_OUTPUTS; i++) {
-                display.setCursor(10, yPosition);
-                display.print("OUTPUT " + String(i + 1) + ":");
-                display.setCursor(70, yPosition);
-                display.print(outputs[i].GetPulseProbabilityDescription());
-                if (menuItem == menuIdx + i) {
-                    if (menuMode == 0) {
-                        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    } else if (menuMode == menuIdx + i) {
-                        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    }
-                }
-                yPosition += 9;
-            }
-            RedrawDisplay();
-            return;
+    if (menuMode >= 0 && menuMode <= 2) {
+        display.setTextSize(2);
+        display.setCursor(44, 27);
+        if (menuItem == 2) {
+            display.drawLine(43, 42, 88, 42, 1);
         }
-
-        // Euclidean rhythm menu
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 6;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("EUCLIDEAN RHYTHM");
-            int yPosition = 20;
-            int xPosition = 64;
-            display.setCursor(10, yPosition);
-            display.print("OUTPUT: ");
-            display.setCursor(xPosition, yPosition);
-            display.print(String(euclideanOutputSelect + 1));
-            if (menuItem == menuIdx && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("ENABLED: ");
-            display.setCursor(xPosition, yPosition);
-            display.print(String(outputs[euclideanOutputSelect].GetEuclidean() ? "YES" : "NO"));
-            if (menuItem == menuIdx + 1 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 1) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("STEPS: ");
-            display.setCursor(xPosition, yPosition);
-            display.print(String(outputs[euclideanOutputSelect].GetEuclideanSteps()));
-            if (menuItem == menuIdx + 2 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 2) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("HITS: ");
-            display.setCursor(xPosition, yPosition);
-            display.print(String(outputs[euclideanOutputSelect].GetEuclideanTriggers()));
-            if (menuItem == menuIdx + 3 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 3) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("ROT:");
-            display.print(String(outputs[euclideanOutputSelect].GetEuclideanRotation()));
-            if (menuItem == menuIdx + 4 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 4) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-
-            display.setCursor(xPosition, yPosition);
-            display.print("PAD:");
-            display.print(String(outputs[euclideanOutputSelect].GetEuclideanPadding()));
-            if (menuItem == menuIdx + 5 && menuMode == 0) {
-                display.drawTriangle(xPosition - 8, yPosition - 1, xPosition - 8, yPosition + 7, xPosition - 4, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 5) {
-                display.fillTriangle(xPosition - 8, yPosition - 1, xPosition - 8, yPosition + 7, xPosition - 4, yPosition + 3, 1);
-            }
-
-            // Draw the Euclidean rhythm pattern for the selected output
-            if (outputs[euclideanOutputSelect].GetEuclidean()) {
-                display.fillTriangle(90, 10, 94, 10, 92, 14, WHITE);
-                yPosition = 15;
-                int euclideanSteps = outputs[euclideanOutputSelect].GetEuclideanSteps();
-                int euclideanPadding = outputs[euclideanOutputSelect].GetEuclideanPadding();
-                for (int i = 0; i < euclideanSteps + euclideanPadding && i < 47; i++) {
-                    int column = i / 8;
-                    int row = i % 8;
-                    display.setCursor(90 + (column * 6), yPosition + (row * 6));
-                    if (i < euclideanSteps && outputs[euclideanOutputSelect].GetRhythmStep(i)) {
-                        display.fillRect(90 + (column * 6), yPosition + (row * 6), 5, 5, WHITE);
-                    } else {
-                        if (i < euclideanSteps) {
-                            display.drawRect(90 + (column * 6), yPosition + (row * 6), 5, 5, WHITE);
-                        } else {
-                            display.drawRect(90 + (column * 6), yPosition + (row * 6), 5, 5, WHITE);
-                            display.writePixel(90 + (column * 6) + 2, yPosition + (row * 6) + 2, WHITE);
-                        }
-                    }
-                }
-                if (euclideanSteps + euclideanPadding > 47) {
-                    display.fillTriangle(120, 57, 124, 57, 122, 61, WHITE);
-                }
-            }
-            RedrawDisplay();
-            return;
+        if (!masterState) {
+            display.fillRoundRect(23, 26, 17, 17, 2, 1);
+            display.print("STOP");
+        } else {
+            display.fillTriangle(23, 26, 23, 42, 39, 34, 1);
+            display.print("PLAY");
         }
+    }
 
-        // Swing amount menu
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 8;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("OUTPUT SWING");
-            int yPosition = 20;
-            display.setCursor(64, yPosition);
-            display.println("AMT");
-            display.setCursor(94, yPosition);
-            display.println("EVERY");
-            yPosition += 9;
-            for (int i = 0; i < NUM_OUTPUTS; i++) {
-                display.setCursor(10, yPosition);
-                display.print("OUTPUT " + String(i + 1) + ":");
-                display.setCursor(70, yPosition);
-                display.print(outputs[i].GetSwingAmountDescription());
-                display.setCursor(100, yPosition);
-                display.print(outputs[i].GetSwingEvery());
-
-                if (menuItem % 2 == 0) {
-                    display.fillTriangle(59, 20, 59, 26, 62, 23, 1);
-                } else {
-                    display.fillTriangle(89, 20, 89, 26, 92, 23, 1);
-                }
-
-                if (menuItem - menuIdx == i * 2 || menuItem - menuIdx == i * 2 + 1) {
-                    if (menuMode == 0) {
-                        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    } else {
-                        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    }
-                }
-                yPosition += 9;
-            }
-            RedrawDisplay();
-            return;
+    // Show a box to each output showing if it's enabled
+    display.setTextSize(1);
+    for (int i = 0; i < NUM_OUTPUTS; i++) {
+        if (outputs[i]->GetOutputState()) {
+            display.fillRect((i * 30) + 14, 46, 9, 9, WHITE);
+            display.setCursor((i * 30) + 16, 47);
+            display.setTextColor(BLACK);
+            display.print(i + 1);
+        } else {
+            display.drawRect((i * 30) + 14, 46, 9, 9, WHITE);
+            display.setCursor((i * 30) + 16, 47);
+            display.setTextColor(WHITE);
+            display.print(i + 1);
         }
+        display.setTextColor(WHITE);
+        const char *s = outputs[i]->GetDividerDescription();
+        display.setCursor((i * 30) + 13 + (6 - (strlen(s) * 3)), 56);
+        display.print(s);
+    }
+}
 
-        // Phase shift menu
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 4;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("PHASE SHIFT");
-            int yPosition = 0;
-            yPosition = 20;
-            for (int i = 0; i < NUM_OUTPUTS; i++) {
-                display.setCursor(10, yPosition);
-                display.print("OUTPUT " + String(i + 1) + ":");
-                display.setCursor(70, yPosition);
-                display.print(outputs[i].GetPhaseDescription());
-                if (menuItem == menuIdx + i) {
-                    if (menuMode == 0) {
-                        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    } else if (menuMode == menuIdx + i) {
-                        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    }
-                }
-                yPosition += 9;
+// Clock dividers
+void DrawDividerPage(int menuIdx, int) {
+    display.setTextSize(1);
+    MenuHeader("CLOCK DIVIDERS");
+    int yPosition = 20;
+    for (int i = 0; i < NUM_OUTPUTS; i++) {
+        display.setCursor(10, yPosition);
+        display.print("OUTPUT ");
+        display.print(i + 1);
+        display.print(":");
+        display.setCursor(84, yPosition);
+        display.print(outputs[i]->GetDividerDescription());
+        if (menuItem == i + menuIdx) {
+            if (menuMode == 0) {
+                display.drawTriangle(1, 19 + (i * 9), 1, 27 + (i * 9), 5, 23 + (i * 9), 1);
+            } else if (menuMode == i + menuIdx) {
+                display.fillTriangle(1, 19 + (i * 9), 1, 27 + (i * 9), 5, 23 + (i * 9), 1);
             }
-            RedrawDisplay();
-            return;
         }
-
-        // Duty cycle menu
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 4;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("OUTPUT SETTINGS");
-            int yPosition = 21;
-
-            for (int i = 0; i < itemAmount; i++) {
-                display.setCursor(10, yPosition);
-                display.print("OUT " + String(i + 1) + " DUTY: ");
-                display.print(outputs[i].GetDutyCycleDescription());
-                if (menuItem == menuIdx + i && menuMode == 0) {
-                    display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                } else if (menuMode == menuIdx + i) {
-                    display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                }
-                yPosition += 9;
-            }
-
-            RedrawDisplay();
-            return;
+        yPosition += 9;
+    }
+    // For external clock divider
+    display.setCursor(10, yPosition);
+    display.print("EXT. DIV:");
+    display.setCursor(84, yPosition);
+    display.print(externalDividerDescription[externalDividerIndex]);
+    if (menuItem == 7) {
+        if (menuMode == 0) {
+            display.drawTriangle(1, 19 + (NUM_OUTPUTS * 9), 1, 27 + (NUM_OUTPUTS * 9), 5, 23 + (NUM_OUTPUTS * 9), 1);
+        } else if (menuMode == 7) {
+            display.fillTriangle(1, 19 + (NUM_OUTPUTS * 9), 1, 27 + (NUM_OUTPUTS * 9), 5, 23 + (NUM_OUTPUTS * 9), 1);
         }
+    }
+}
 
-        // Level/Offset/Waveform control menu
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 6;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("OUTPUT SETTINGS");
-            int yPosition = 12;
-
-            // Levels and offsets
-            display.setCursor(70, yPosition);
-            display.println("LVL");
-            display.setCursor(100, yPosition);
-            display.println("OFF");
-            if (menuItem == menuIdx || menuItem == menuIdx + 2) {
-                display.fillTriangle(65, yPosition, 65, yPosition + 6, 68, yPosition + 3, 1);
-            }
-            if (menuItem == menuIdx + 1 || menuItem == menuIdx + 3) {
-                display.fillTriangle(95, yPosition, 95, yPosition + 6, 98, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            for (int i = 2; i < NUM_OUTPUTS; i++) {
-                display.setCursor(10, yPosition);
-                display.print("OUTPUT " + String(i + 1) + ":");
-                display.setCursor(70, yPosition);
-                display.print(outputs[i].GetLevelDescription());
-                display.setCursor(100, yPosition);
-                display.print(outputs[i].GetOffsetDescription());
-
-                if (menuItem == menuIdx + (i - 2) * 2 || menuItem == menuIdx + 1 + (i - 2) * 2) {
-                    if (menuMode == 0) {
-                        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    } else {
-                        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    }
-                }
-                yPosition += 9;
-            }
-            // Waveform type
-            yPosition += 7;
-            display.setCursor(10, yPosition);
-            display.println("OUT 3 WAV:");
-            display.setCursor(70, yPosition);
-            display.print(outputs[2].GetWaveformTypeDescription());
-            if (menuItem == menuIdx + 4 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 4) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.println("OUT 4 WAV:");
-            display.setCursor(70, yPosition);
-            display.print(outputs[3].GetWaveformTypeDescription());
-            if (menuItem == menuIdx + 5 && menuMode == 0) {
+// Clock outputs state
+void DrawOutputStatePage(int menuIdx, int) {
+    display.setTextSize(1);
+    MenuHeader("OUTPUT STATE");
+    int yPosition = 20;
+    for (int i = 0; i < NUM_OUTPUTS; i++) {
+        display.setCursor(10, yPosition);
+        display.print("OUTPUT ");
+        display.print(i + 1);
+        display.print(":");
+        display.setCursor(70, yPosition);
+        display.print(outputs[i]->GetOutputState() ? "ON" : "OFF");
+        if (menuItem == i + menuIdx) {
+            if (menuMode == 0) {
                 display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 5) {
+            } else if (menuMode == i + menuIdx) {
                 display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
             }
-
-            RedrawDisplay();
-            return;
         }
+        yPosition += 9;
+    }
+}
 
-        // Envelope settings
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 7;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("ENVELOPE SETTINGS");
-            int yPosition = 10;
-            int xPosition = 64;
-            display.setCursor(10, yPosition);
-            display.print("OUTPUT: ");
-            display.setCursor(xPosition, yPosition);
-            display.print(String(envelopeOutputSelect + 1));
-            if (menuItem == menuIdx && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("Attack: ");
-            display.setCursor(xPosition, yPosition);
-            display.print(String(outputs[envelopeOutputSelect].GetAttackDescription()));
-            if (menuItem == menuIdx + 1 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 1) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("Decay: ");
-            display.setCursor(xPosition, yPosition);
-            display.print(String(outputs[envelopeOutputSelect].GetDecayDescription()));
-            if (menuItem == menuIdx + 2 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 2) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("Sustain: ");
-            display.setCursor(xPosition, yPosition);
-            display.print(String(outputs[envelopeOutputSelect].GetSustainDescription()));
-            if (menuItem == menuIdx + 3 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 3) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("Release: ");
-            display.setCursor(xPosition, yPosition);
-            display.print(String(outputs[envelopeOutputSelect].GetReleaseDescription()));
-            if (menuItem == menuIdx + 4 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 4) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("Curv:");
-            display.print(String(outputs[envelopeOutputSelect].GetCurveDescription()));
-            if (menuItem == menuIdx + 5 && menuMode == 0) {
+// Pulse probability
+void DrawProbabilityPage(int menuIdx, int) {
+    char text[DESCRIPTION_LENGTH]; // Numbers with their units are written here before printing
+    display.setTextSize(1);
+    MenuHeader("PROBABILITY");
+    int yPosition = 20;
+    for (int i = 0; i < NUM_OUTPUTS; i++) {
+        display.setCursor(10, yPosition);
+        display.print("OUTPUT ");
+        display.print(i + 1);
+        display.print(":");
+        display.setCursor(70, yPosition);
+        display.print(outputs[i]->GetPulseProbabilityDescription(text));
+        if (menuItem == menuIdx + i) {
+            if (menuMode == 0) {
                 display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 5) {
+            } else if (menuMode == menuIdx + i) {
                 display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
             }
+        }
+        yPosition += 9;
+    }
+}
 
-            display.setCursor(64, yPosition);
-            display.print("Retr:");
-            display.print(String(outputs[envelopeOutputSelect].GetRetriggerDescription()));
-            if (menuItem == menuIdx + 6 && menuMode == 0) {
-                display.drawTriangle(56, yPosition - 1, 56, yPosition + 7, 60, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 6) {
-                display.fillTriangle(56, yPosition - 1, 56, yPosition + 7, 60, yPosition + 3, 1);
+// Euclidean rhythm
+void DrawEuclideanPage(int menuIdx, int) {
+    display.setTextSize(1);
+    MenuHeader("EUCLIDEAN RHYTHM");
+    int yPosition = 20;
+    int xPosition = 64;
+    display.setCursor(10, yPosition);
+    display.print("OUTPUT: ");
+    display.setCursor(xPosition, yPosition);
+    display.print(euclideanOutputSelect + 1);
+    if (menuItem == menuIdx && menuMode == 0) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    } else if (menuMode == menuIdx) {
+        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+    yPosition += 9;
+    display.setCursor(10, yPosition);
+    display.print("ENABLED: ");
+    display.setCursor(xPosition, yPosition);
+    display.print(outputs[euclideanOutputSelect]->GetEuclidean() ? "YES" : "NO");
+    if (menuItem == menuIdx + 1 && menuMode == 0) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    } else if (menuMode == menuIdx + 1) {
+        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+    yPosition += 9;
+    display.setCursor(10, yPosition);
+    display.print("STEPS: ");
+    display.setCursor(xPosition, yPosition);
+    display.print(outputs[euclideanOutputSelect]->GetEuclideanSteps());
+    if (menuItem == menuIdx + 2 && menuMode == 0) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    } else if (menuMode == menuIdx + 2) {
+        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+    yPosition += 9;
+    display.setCursor(10, yPosition);
+    display.print("HITS: ");
+    display.setCursor(xPosition, yPosition);
+    display.print(outputs[euclideanOutputSelect]->GetEuclideanTriggers());
+    if (menuItem == menuIdx + 3 && menuMode == 0) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    } else if (menuMode == menuIdx + 3) {
+        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+    yPosition += 9;
+    display.setCursor(10, yPosition);
+    display.print("ROT:");
+    display.print(outputs[euclideanOutputSelect]->GetEuclideanRotation());
+    if (menuItem == menuIdx + 4 && menuMode == 0) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    } else if (menuMode == menuIdx + 4) {
+        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+
+    display.setCursor(xPosition, yPosition);
+    display.print("PAD:");
+    display.print(outputs[euclideanOutputSelect]->GetEuclideanPadding());
+    if (menuItem == menuIdx + 5 && menuMode == 0) {
+        display.drawTriangle(xPosition - 8, yPosition - 1, xPosition - 8, yPosition + 7, xPosition - 4, yPosition + 3, 1);
+    } else if (menuMode == menuIdx + 5) {
+        display.fillTriangle(xPosition - 8, yPosition - 1, xPosition - 8, yPosition + 7, xPosition - 4, yPosition + 3, 1);
+    }
+
+    // Draw the Euclidean rhythm pattern for the selected output
+    if (outputs[euclideanOutputSelect]->GetEuclidean()) {
+        display.fillTriangle(90, 10, 94, 10, 92, 14, WHITE);
+        yPosition = 15;
+        int euclideanSteps = outputs[euclideanOutputSelect]->GetEuclideanSteps();
+        int euclideanPadding = outputs[euclideanOutputSelect]->GetEuclideanPadding();
+        for (int i = 0; i < euclideanSteps + euclideanPadding && i < 47; i++) {
+            int column = i / 8;
+            int row = i % 8;
+            display.setCursor(90 + (column * 6), yPosition + (row * 6));
+            if (i < euclideanSteps && outputs[euclideanOutputSelect]->GetRhythmStep(i)) {
+                display.fillRect(90 + (column * 6), yPosition + (row * 6), 5, 5, WHITE);
+            } else {
+                if (i < euclideanSteps) {
+                    display.drawRect(90 + (column * 6), yPosition + (row * 6), 5, 5, WHITE);
+                } else {
+                    display.drawRect(90 + (column * 6), yPosition + (row * 6), 5, 5, WHITE);
+                    display.writePixel(90 + (column * 6) + 2, yPosition + (row * 6) + 2, WHITE);
+                }
             }
+        }
+        if (euclideanSteps + euclideanPadding > 47) {
+            display.fillTriangle(120, 57, 124, 57, 122, 61, WHITE);
+        }
+    }
+}
 
-            RedrawDisplay();
-            return;
+// Swing amount
+void DrawSwingPage(int menuIdx, int) {
+    display.setTextSize(1);
+    MenuHeader("OUTPUT SWING");
+    int yPosition = 20;
+    display.setCursor(64, yPosition);
+    display.println("AMT");
+    display.setCursor(94, yPosition);
+    display.println("EVERY");
+    yPosition += 9;
+    for (int i = 0; i < NUM_OUTPUTS; i++) {
+        display.setCursor(10, yPosition);
+        display.print("OUTPUT ");
+        display.print(i + 1);
+        display.print(":");
+        display.setCursor(70, yPosition);
+        display.print(outputs[i]->GetSwingAmountDescription());
+        display.setCursor(100, yPosition);
+        display.print(outputs[i]->GetSwingEvery());
+
+        if (menuItem % 2 == 0) {
+            display.fillTriangle(59, 20, 59, 26, 62, 23, 1);
+        } else {
+            display.fillTriangle(89, 20, 89, 26, 92, 23, 1);
         }
 
-        // CV input target menu
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 6;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("CV INPUT TARGETS");
-            int yPosition = 20;
-            display.setCursor(10, yPosition);
-            display.print("CV 1: ");
-            display.print(CVTargetDescription[menuMode == 51 ? pendingCVInputTarget[0] : CVInputTarget[0]]);
-
-            if (menuItem == menuIdx && menuMode == 0) {
+        if (menuItem - menuIdx == i * 2 || menuItem - menuIdx == i * 2 + 1) {
+            if (menuMode == 0) {
                 display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx) {
+            } else {
                 display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
             }
+        }
+        yPosition += 9;
+    }
+}
 
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("CV 2: ");
-            display.print(CVTargetDescription[menuMode == 52 ? pendingCVInputTarget[1] : CVInputTarget[1]]);
-            if (menuItem == menuIdx + 1 && menuMode == 0) {
+// Phase shift
+void DrawPhasePage(int menuIdx, int) {
+    char text[DESCRIPTION_LENGTH]; // Numbers with their units are written here before printing
+    display.setTextSize(1);
+    MenuHeader("PHASE SHIFT");
+    int yPosition = 0;
+    yPosition = 20;
+    for (int i = 0; i < NUM_OUTPUTS; i++) {
+        display.setCursor(10, yPosition);
+        display.print("OUTPUT ");
+        display.print(i + 1);
+        display.print(":");
+        display.setCursor(70, yPosition);
+        display.print(outputs[i]->GetPhaseDescription(text));
+        if (menuItem == menuIdx + i) {
+            if (menuMode == 0) {
                 display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 1) {
+            } else if (menuMode == menuIdx + i) {
                 display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
             }
-            yPosition += 9;
-            // Levels and offsets
-            display.setCursor(60, yPosition);
-            display.println("ATTN");
-            display.setCursor(100, yPosition);
-            display.println("OFF");
-            if (menuItem == menuIdx + 2 || menuItem == menuIdx + 4) {
-                display.fillTriangle(55, yPosition, 55, yPosition + 6, 58, yPosition + 3, 1);
-            }
-            if (menuItem == menuIdx + 3 || menuItem == menuIdx + 5) {
-                display.fillTriangle(95, yPosition, 95, yPosition + 6, 98, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            for (int i = 0; i < NUM_CV_INS; i++) {
-                display.setCursor(10, yPosition);
-                display.print("CV " + String(i + 1) + ":");
-                display.setCursor(60, yPosition);
-                display.print(String(CVInputAttenuation[i]) + "%");
-                display.setCursor(100, yPosition);
-                display.print(String(CVInputOffset[i]) + "%");
-
-                if (menuItem == menuIdx + 2 + (i) * 2 || menuItem == menuIdx + 3 + (i) * 2) {
-                    if (menuMode == 0) {
-                        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    } else {
-                        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    }
-                }
-                yPosition += 9;
-            }
+        }
+        yPosition += 9;
+    }
+}
 
-            RedrawDisplay();
-            return;
+// Duty cycle
+void DrawDutyCyclePage(int menuIdx, int itemAmount) {
+    char text[DESCRIPTION_LENGTH]; // Numbers with their units are written here before printing
+    display.setTextSize(1);
+    MenuHeader("OUTPUT SETTINGS");
+    int yPosition = 21;
+
+    for (int i = 0; i < itemAmount; i++) {
+        display.setCursor(10, yPosition);
+        display.print("OUT ");
+        display.print(i + 1);
+        display.print(" DUTY: ");
+        display.print(outputs[i]->GetDutyCycleDescription(text));
+        if (menuItem == menuIdx + i && menuMode == 0) {
+            display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+        } else if (menuMode == menuIdx + i) {
+            display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
         }
+        yPosition += 9;
+    }
+}
 
-        // Quantize menu
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 5;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("QUANTIZE SETTINGS");
-            int yPosition = 20;
-            display.setCursor(10, yPosition);
-            display.print("OUTPUT: ");
-            display.print(String(quantizerOutputSelect + 1));
-            if (menuItem == menuIdx && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("ENABLED: ");
-            display.print(String(outputs[quantizerOutputSelect].GetQuantizerEnable() ? "YES" : "NO"));
-            if (menuItem == menuIdx + 1 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 1) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("ROOT NOTE: ");
-            display.print(String(outputs[quantizerOutputSelect].GetQuantizerNoteDescription()));
-            if (menuItem == menuIdx + 2 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 2) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("SCALE: ");
-            display.print(String(outputs[quantizerOutputSelect].GetQuantizerScaleDescription()));
-            if (menuItem == menuIdx + 3 && menuMode == 0) {
+// Level, offset and waveform
+void DrawLevelPage(int menuIdx, int) {
+    char text[DESCRIPTION_LENGTH]; // Numbers with their units are written here before printing
+    display.setTextSize(1);
+    MenuHeader("OUTPUT SETTINGS");
+    int yPosition = 12;
+
+    // Levels and offsets
+    display.setCursor(70, yPosition);
+    display.println("LVL");
+    display.setCursor(100, yPosition);
+    display.println("OFF");
+    if (menuItem == menuIdx || menuItem == menuIdx + 2) {
+        display.fillTriangle(65, yPosition, 65, yPosition + 6, 68, yPosition + 3, 1);
+    }
+    if (menuItem == menuIdx + 1 || menuItem == menuIdx + 3) {
+        display.fillTriangle(95, yPosition, 95, yPosition + 6, 98, yPosition + 3, 1);
+    }
+    yPosition += 9;
+    for (int i = 2; i < NUM_OUTPUTS; i++) {
+        display.setCursor(10, yPosition);
+        display.print("OUTPUT ");
+        display.print(i + 1);
+        display.print(":");
+        display.setCursor(70, yPosition);
+        display.print(dacOutputs[i - 2].GetLevelDescription(text));
+        display.setCursor(100, yPosition);
+        display.print(dacOutputs[i - 2].GetOffsetDescription(text));
+
+        if (menuItem == menuIdx + (i - 2) * 2 || menuItem == menuIdx + 1 + (i - 2) * 2) {
+            if (menuMode == 0) {
                 display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 3) {
+            } else {
                 display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
             }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("OCT TRANSPOSE:");
-            display.print(String(outputs[quantizerOutputSelect].GetQuantizerOctaveShiftDescription()));
-            if (menuItem == menuIdx + 4 && menuMode == 0) {
+        }
+        yPosition += 9;
+    }
+    // Waveform type
+    yPosition -= 2;
+    for (int i = 0; i < NUM_DAC_OUTS; i++) {
+        int item = menuIdx + levelPageWaveformItem + i;
+        yPosition += 9;
+        display.setCursor(10, yPosition);
+        display.print("OUT ");
+        display.print(NUM_GATE_OUTS + i + 1);
+        display.println(" WAV:");
+        display.setCursor(70, yPosition);
+        display.print(dacOutputs[i].GetWaveformTypeDescription());
+        if (menuItem == item && menuMode == 0) {
+            display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+        } else if (menuMode == item) {
+            display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+        }
+    }
+}
+
+// Envelope settings
+void DrawEnvelopePage(int menuIdx, int) {
+    char text[DESCRIPTION_LENGTH]; // Numbers with their units are written here before printing
+    display.setTextSize(1);
+    MenuHeader("ENVELOPE SETTINGS");
+    int yPosition = 10;
+    int xPosition = 64;
+    display.setCursor(10, yPosition);
+    display.print("OUTPUT: ");
+    display.setCursor(xPosition, yPosition);
+    display.print(NUM_GATE_OUTS + envelopeOutputSelect + 1);
+    if (menuItem == menuIdx && menuMode == 0) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    } else if (menuMode == menuIdx) {
+        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+    yPosition += 9;
+    display.setCursor(10, yPosition);
+    display.print("Attack: ");
+    display.setCursor(xPosition, yPosition);
+    display.print(dacOutputs[envelopeOutputSelect].GetAttackDescription(text));
+    if (menuItem == menuIdx + 1 && menuMode == 0) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    } else if (menuMode == menuIdx + 1) {
+        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+    yPosition += 9;
+    display.setCursor(10, yPosition);
+    display.print("Decay: ");
+    display.setCursor(xPosition, yPosition);
+    display.print(dacOutputs[envelopeOutputSelect].GetDecayDescription(text));
+    if (menuItem == menuIdx + 2 && menuMode == 0) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    } else if (menuMode == menuIdx + 2) {
+        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+    yPosition += 9;
+    display.setCursor(10, yPosition);
+    display.print("Sustain: ");
+    display.setCursor(xPosition, yPosition);
+    display.print(dacOutputs[envelopeOutputSelect].GetSustainDescription(text));
+    if (menuItem == menuIdx + 3 && menuMode == 0) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    } else if (menuMode == menuIdx + 3) {
+        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+    yPosition += 9;
+    display.setCursor(10, yPosition);
+    display.print("Release: ");
+    display.setCursor(xPosition, yPosition);
+    display.print(dacOutputs[envelopeOutputSelect].GetReleaseDescription(text));
+    if (menuItem == menuIdx + 4 && menuMode == 0) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    } else if (menuMode == menuIdx + 4) {
+        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+    yPosition += 9;
+    display.setCursor(10, yPosition);
+    display.print("Curv:");
+    display.print(dacOutputs[envelopeOutputSelect].GetCurveDescription(text));
+    if (menuItem == menuIdx + 5 && menuMode == 0) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    } else if (menuMode == menuIdx + 5) {
+        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+
+    display.setCursor(64, yPosition);
+    display.print("Retr:");
+    display.print(dacOutputs[envelopeOutputSelect].GetRetriggerDescription());
+    if (menuItem == menuIdx + 6 && menuMode == 0) {
+        display.drawTriangle(56, yPosition - 1, 56, yPosition + 7, 60, yPosition + 3, 1);
+    } else if (menuMode == menuIdx + 6) {
+        display.fillTriangle(56, yPosition - 1, 56, yPosition + 7, 60, yPosition + 3, 1);
+    }
+}
+
+// CV input targets
+void DrawCVInputPage(int menuIdx, int) {
+    display.setTextSize(1);
+    MenuHeader("CV INPUT TARGETS");
+    int yPosition = 11;
+    display.setCursor(10, yPosition);
+    display.print("ROUTE: ");
+    display.print(cvRouteSelect + 1);
+    display.print("/");
+    display.print(CV_ROUTES);
+    if (menuItem == menuIdx && menuMode == 0) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    } else if (menuMode == menuIdx) {
+        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+    yPosition += 9;
+
+    for (int i = 0; i < NUM_CV_INS; i++) {
+        int item = menuIdx + 1 + i;
+        display.setCursor(10, yPosition);
+        display.print("CV ");
+        display.print(i + 1);
+        display.print(": ");
+        display.print(CVTargetDescription[menuMode == item ? pendingCVInputTarget[i] : CVInputTarget[i][cvRouteSelect]]);
+        if (menuItem == item && menuMode == 0) {
+            display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+        } else if (menuMode == item) {
+            display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+        }
+        yPosition += 9;
+    }
+    // Levels and offsets
+    int levelIdx = menuIdx + 1 + NUM_CV_INS;
+    display.setCursor(60, yPosition);
+    display.println("ATTN");
+    display.setCursor(100, yPosition);
+    display.println("OFF");
+    if (menuItem == levelIdx || menuItem == levelIdx + 2) {
+        display.fillTriangle(55, yPosition, 55, yPosition + 6, 58, yPosition + 3, 1);
+    }
+    if (menuItem == levelIdx + 1 || menuItem == levelIdx + 3) {
+        display.fillTriangle(95, yPosition, 95, yPosition + 6, 98, yPosition + 3, 1);
+    }
+    yPosition += 9;
+    for (int i = 0; i < NUM_CV_INS; i++) {
+        display.setCursor(10, yPosition);
+        display.print("CV ");
+        display.print(i + 1);
+        display.print(":");
+        display.setCursor(60, yPosition);
+        display.print(CVInputAttenuation[i][cvRouteSelect]);
+        display.print("%");
+        display.setCursor(100, yPosition);
+        display.print(CVInputOffset[i][cvRouteSelect]);
+        display.print("%");
+
+        if (menuItem == levelIdx + i * 2 || menuItem == levelIdx + 1 + i * 2) {
+            if (menuMode == 0) {
                 display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 4) {
+            } else {
                 display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
             }
+        }
+        yPosition += 9;
+    }
+}
+
+// Quantizer
+void DrawQuantizerPage(int menuIdx, int) {
+    char text[DESCRIPTION_LENGTH]; // Numbers with their units are written here before printing
+    display.setTextSize(1);
+    MenuHeader("QUANTIZE SETTINGS");
+    int yPosition = 20;
+    display.setCursor(10, yPosition);
+    display.print("OUTPUT: ");
+    display.print(NUM_GATE_OUTS + quantizerOutputSelect + 1);
+    if (menuItem == menuIdx && menuMode == 0) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    } else if (menuMode == menuIdx) {
+        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+    yPosition += 9;
+    display.setCursor(10, yPosition);
+    display.print("ENABLED: ");
+    display.print(dacOutputs[quantizerOutputSelect].GetQuantizerEnable() ? "YES" : "NO");
+    if (menuItem == menuIdx + 1 && menuMode == 0) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    } else if (menuMode == menuIdx + 1) {
+        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+    yPosition += 9;
+    display.setCursor(10, yPosition);
+    display.print("ROOT NOTE: ");
+    display.print(dacOutputs[quantizerOutputSelect].GetQuantizerNoteDescription());
+    if (menuItem == menuIdx + 2 && menuMode == 0) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    } else if (menuMode == menuIdx + 2) {
+        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+    yPosition += 9;
+    display.setCursor(10, yPosition);
+    display.print("SCALE: ");
+    display.print(dacOutputs[quantizerOutputSelect].GetQuantizerScaleDescription());
+    if (menuItem == menuIdx + 3 && menuMode == 0) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    } else if (menuMode == menuIdx + 3) {
+        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+    yPosition += 9;
+    display.setCursor(10, yPosition);
+    display.print("OCT TRANSPOSE:");
+    display.print(dacOutputs[quantizerOutputSelect].GetQuantizerOctaveShiftDescription(text));
+    if (menuItem == menuIdx + 4 && menuMode == 0) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    } else if (menuMode == menuIdx + 4) {
+        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+}
+
+// Tap tempo and presets
+void DrawSettingsPage(int menuIdx, int) {
+    display.setTextSize(1);
+    int yPosition = 9;
+    // Tap tempo
+    display.setCursor(10, yPosition);
+    display.print("TAP TEMPO");
+    display.print(" (");
+    display.print(BPM);
+    display.print(" BPM)");
+    if (menuItem == menuIdx) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+    yPosition += 9;
+    yPosition += 9;
+    // Save
+    display.setCursor(10, yPosition);
+    display.print("PRESET SLOT: ");
+    display.print(saveSlot);
+    if (menuItem == menuIdx + 1 && menuMode == 0) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    } else if (menuMode == menuIdx + 1) {
+        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+    yPosition += 9;
+    display.setCursor(10, yPosition);
+    display.print("SAVE");
+    if (menuItem == menuIdx + 2) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+    yPosition += 9;
+    display.setCursor(10, yPosition);
+    display.print("LOAD");
+    if (menuItem == menuIdx + 3) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+    yPosition += 9;
+    // Load default settings
+    display.setCursor(10, yPosition);
+    display.print("LOAD DEFAULTS");
+    if (menuItem == menuIdx + 4) {
+        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+    }
+}
 
-            RedrawDisplay();
-            return;
+constexpr MenuPage menuPages[] = {
+    {2, DrawMainPage},
+    {5, DrawDividerPage},
+    {4, DrawOutputStatePage},
+    {4, DrawProbabilityPage},
+    {6, DrawEuclideanPage},
+    {8, DrawSwingPage},
+    {4, DrawPhasePage},
+    {4, DrawDutyCyclePage},
+    {6, DrawLevelPage},
+    {7, DrawEnvelopePage},
+    {7, DrawCVInputPage},
+    {5, DrawQuantizerPage},
+    {5, DrawSettingsPage},
+};
+int const menuPageAmount = sizeof(menuPages) / sizeof(menuPages[0]);
+static_assert(MenuPageItems(menuPages, menuPageAmount) == menuItems, "The menu pages must cover every menu entry");
+
+// Page of every item and first item of every page, filled in by InitMenu()
+uint8_t menuItemPage[menuItems];
+int menuPageFirstItem[menuPageAmount];
+
+void InitMenu() {
+    int item = 0;
+    for (int page = 0; page < menuPageAmount; page++) {
+        menuPageFirstItem[page] = item + 1;
+        for (int i = 0; i < menuPages[page].items; i++) {
+            menuItemPage[item++] = page;
         }
+    }
+}
 
-        // Other settings
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 5;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            int yPosition = 9;
-            // Tap tempo
-            display.setCursor(10, yPosition);
-            display.print("TAP TEMPO");
-            display.print(" (" + String(BPM) + " BPM)");
-            if (menuItem == menuIdx) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            yPosition += 9;
-            // Save
-            display.setCursor(10, yPosition);
-            display.print("PRESET SLOT: ");
-            display.print(saveSlot);
-            if (menuItem == menuIdx + 1 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 1) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("SAVE");
-            if (menuItem == menuIdx + 2) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("LOAD");
-            if (menuItem == menuIdx + 3) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+// Position of an item on its page
+int MenuIndex(int item) {
+    return item - menuPageFirstItem[menuItemPage[item - 1]];
+}
+
+// Handle encoder button click
+void HandleEncoderClick() {
+    oldSwitchState = switchState;
+    switchState = digitalRead(ENCODER_SW);
+    if (switchState == 1 && oldSwitchState == 0) {
+        lastEncoderUpdate = millis();
+        displayRefresh = 1;
+        if (menuMode == 0) {
+            const MenuEntry &entry = menuEntries[menuItem - 1];
+            if (entry.adjust) {
+                // Enter edit mode
+                if (entry.enter) {
+                    entry.enter(MenuIndex(menuItem));
+                }
+                menuMode = menuItem;
+            } else {
+                entry.select(MenuIndex(menuItem));
+                if (entry.unsaved) {
+                    unsavedChanges = true;
+                }
             }
-            yPosition += 9;
-            // Load default settings
-            display.setCursor(10, yPosition);
-            display.print("LOAD DEFAULTS");
-            if (menuItem == menuIdx + 4) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
+        } else {
+            // Commit changes after exiting edit mode
+            const MenuEntry &entry = menuEntries[menuMode - 1];
+            if (entry.exit) {
+                entry.exit(MenuIndex(menuMode));
             }
+            menuMode = 0;
+        }
+    }
+}
+
+void HandleEncoderPosition() {
+    newPosition = encoder.read();
 
-            RedrawDisplay();
-            return;
+    int direction = 0;
+    if ((newPosition - 3) / 4 > oldPosition / 4) { // Decrease, turned counter-clockwise
+        direction = -1;
+    } else if ((newPosition + 3) / 4 < oldPosition / 4) { // Increase, turned clockwise
+        direction = 1;
+    }
+    if (direction == 0) {
+        return;
+    }
+    UpdateSpeedFactor();
+    oldPosition = newPosition;
+    displayRefresh = 1;
+    lastEncoderUpdate = millis();
+
+    if (menuMode == 0) {
+        menuItem = (menuItem - 1 + direction + menuItems) % menuItems + 1;
+    } else {
+        const MenuEntry &entry = menuEntries[menuMode - 1];
+        entry.adjust(MenuIndex(menuMode), direction);
+        if (entry.unsaved) {
+            unsavedChanges = true;
         }
     }
+}
+
+// Handle display drawing
+void HandleDisplay() {
+    // Only refresh the display at a reasonable rate
+    unsigned long currentTime = millis();
+
+    if (displayRefresh && (currentTime - lastDisplayUpdateTime >= DISPLAY_UPDATE_INTERVAL)) {
+        lastDisplayUpdateTime = currentTime;
+
+        display.clearDisplay();
+        MenuIndicator();
+
+        // Draw the page of the current item, only the parts that changed go out to the display
+        int page = menuItemPage[menuItem - 1];
+        menuPages[page].draw(menuPageFirstItem[page], menuPages[page].items);
+        RedrawDisplay();
+    }
 
     // If more than 5 seconds have passed, return to the main screen
     if (millis() - lastEncoderUpdate > 7000 && menuItem != 1 && menuItem != 2 && menuMode == 0) {
@@ -1645,264 +1372,402 @@ void SetMasterState(bool state) {
     // If toggling from off to on, reset the tick counters
     if (!masterState && state) {
         tickCounter = 0;
-        externalTickCounter = 0;
+        clockSync.Reset();
     }
     masterState = state;
-    for (int i = 0; i < NUM_OUTPUTS; i++) {
-        outputs[i].SetMasterState(state);
+    for (int i = 0; i < NUM_GATE_OUTS; i++) {
+        gateOutputs[i].SetMasterState(state);
+    }
+    for (int i = 0; i < NUM_DAC_OUTS; i++) {
+        dacOutputs[i].SetMasterState(state);
     }
 }
 
 // Adjust the ADC readings
-void AdjustADCReadings(int CV_IN_PIN, int ch) {
+void AdjustADCReadings(int ch) {
     // Apply calibration
-    float calibratedReading = max((analogRead(CV_IN_PIN) - ADCOffset[ch]) * ADCCal[ch], 0.0f);
+    float calibratedReading = max((ReadADCScan(ch) - ADCOffset[ch]) * ADCCal[ch], 0.0f);
     channelADC[ch] = calibratedReading;
 }
 
+// Read and condition the CV inputs on the CV tick of the render interrupt, the matrix only passes on
+// the targets whose value changed
 void HandleCVInputs() {
     for (int i = 0; i < NUM_CV_INS; i++) {
-        oldChannelADC[i] = channelADC[i];
-        AdjustADCReadings(CV_IN_PINS[i], i);
-        ONE_POLE(channelADC[i], oldChannelADC[i], 0.5f);
-        if (abs(channelADC[i] - oldChannelADC[i]) > 10) {
-            HandleCVTarget(i, channelADC[i], CVInputTarget[i]);
-        }
+        AdjustADCReadings(i);
+        modMatrix.Process(i, cvInputs[i].Process(channelADC[i]), ApplyCVTarget);
     }
+    ServiceADCGates();
 }
 
-volatile bool lastResetState = false;
-// Handle the CV target based on the CV value
-void HandleCVTarget(int ch, float CVValue, CVTarget cvTarget) {
-    // Attenuate and offset the CVValue
-    float attenuatedValue = CVValue * ((100 - CVInputAttenuation[ch]) / 100.0f);
-    float offsetValue = attenuatedValue + (CVInputOffset[ch] / 100.0f * MAXDAC);
-    CVValue = constrain(offsetValue, 0, MAXDAC);
+// CV target handlers, each gets the output it acts on and the value the route worked out
+void ApplyStartStop(int, int32_t value) {
+    SetMasterState(value);
+}
 
-    // DEBUG_PRINT("Ch: " + String(ch) + " CV Target: " + String(cvTarget) + " CV Value: " + String(CVValue) + "\n");
-    switch (cvTarget) {
-    case CVTarget::None:
-        break;
-    case CVTarget::StartStop:
-        if (CVValue > MAXDAC / 2) {
-            SetMasterState(true);
-        } else {
-            SetMasterState(false);
-        }
-        break;
-    case CVTarget::Reset:
-        if (CVValue > MAXDAC / 2 && !lastResetState) {
-            tickCounter = 0;
-            externalTickCounter = 0;
-            lastResetState = true;
-        } else if (CVValue < MAXDAC / 2) {
-            lastResetState = false;
-        }
-        break;
-    case CVTarget::SetBPM:
-        // Convert float value to BPM range
-        UpdateBPM(map(CVValue, 0, MAXDAC, minBPM, maxBPM));
-        break;
-    case CVTarget::Div1:
-        outputs[0].SetDivider(map(CVValue, 0, MAXDAC, 0, outputs[0].GetDividerAmounts()));
-        break;
-    case CVTarget::Div2:
-        outputs[1].SetDivider(map(CVValue, 0, MAXDAC, 0, outputs[1].GetDividerAmounts()));
-        break;
-    case CVTarget::Div3:
-        outputs[2].SetDivider(map(CVValue, 0, MAXDAC, 0, outputs[2].GetDividerAmounts()));
-        break;
-    case CVTarget::Div4:
-        outputs[3].SetDivider(map(CVValue, 0, MAXDAC, 0, outputs[3].GetDividerAmounts()));
-        break;
-    case CVTarget::Output1Prob:
-        outputs[0].SetPulseProbability(map(CVValue, 0, MAXDAC, 1, 100));
-        break;
-    case CVTarget::Output2Prob:
-        outputs[1].SetPulseProbability(map(CVValue, 0, MAXDAC, 1, 100));
-        break;
-    case CVTarget::Output3Prob:
-        outputs[2].SetPulseProbability(map(CVValue, 0, MAXDAC, 1, 100));
-        break;
-    case CVTarget::Output4Prob:
-        outputs[3].SetPulseProbability(map(CVValue, 0, MAXDAC, 1, 100));
-        break;
-    case CVTarget::Swing1Amount:
-        outputs[0].SetSwingAmount(map(CVValue, 0, MAXDAC, 0, outputs[0].GetSwingAmounts()));
-        break;
-    case CVTarget::Swing1Every:
-        outputs[0].SetSwingEvery(map(CVValue, 0, MAXDAC, 1, outputs[0].GetSwingEveryAmounts()));
-        break;
-    case CVTarget::Swing2Amount:
-        outputs[1].SetSwingAmount(map(CVValue, 0, MAXDAC, 0, outputs[1].GetSwingAmounts()));
-        break;
-    case CVTarget::Swing2Every:
-        outputs[1].SetSwingEvery(map(CVValue, 0, MAXDAC, 1, outputs[1].GetSwingEveryAmounts()));
-        break;
-    case CVTarget::Swing3Amount:
-        outputs[2].SetSwingAmount(map(CVValue, 0, MAXDAC, 0, outputs[2].GetSwingAmounts()));
-        break;
-    case CVTarget::Swing3Every:
-        outputs[2].SetSwingEvery(map(CVValue, 0, MAXDAC, 1, outputs[2].GetSwingEveryAmounts()));
-        break;
-    case CVTarget::Swing4Amount:
-        outputs[3].SetSwingAmount(map(CVValue, 0, MAXDAC, 0, outputs[3].GetSwingAmounts()));
-        break;
-    case CVTarget::Swing4Every:
-        outputs[3].SetSwingEvery(map(CVValue, 0, MAXDAC, 1, outputs[3].GetSwingEveryAmounts()));
-        break;
-    case CVTarget::Output3Offset:
-        outputs[2].SetOffset(map(CVValue, 0, MAXDAC, 0, 100));
-        break;
-    case CVTarget::Output4Offset:
-        outputs[3].SetOffset(map(CVValue, 0, MAXDAC, 0, 100));
-        break;
-    case CVTarget::Output3Level:
-        outputs[2].SetLevel(map(CVValue, 0, MAXDAC, 0, 100));
-        break;
-    case CVTarget::Output4Level:
-        outputs[3].SetLevel(map(CVValue, 0, MAXDAC, 0, 100));
-        break;
-    case CVTarget::Output3Waveform:
-        outputs[2].SetWaveformType(static_cast<WaveformType>(map(CVValue, 0, MAXDAC, 0, WaveformTypeLength)));
-        break;
-    case CVTarget::Output4Waveform:
-        outputs[3].SetWaveformType(static_cast<WaveformType>(map(CVValue, 0, MAXDAC, 0, WaveformTypeLength)));
-        break;
-    case CVTarget::Output1Duty:
-        outputs[0].SetDutyCycle(map(CVValue, 0, MAXDAC, 0, 100));
-        break;
-    case CVTarget::Output2Duty:
-        outputs[1].SetDutyCycle(map(CVValue, 0, MAXDAC, 0, 100));
-        break;
-    case CVTarget::Output3Duty:
-        outputs[2].SetDutyCycle(map(CVValue, 0, MAXDAC, 0, 100));
-        break;
-    case CVTarget::Output4Duty:
-        outputs[3].SetDutyCycle(map(CVValue, 0, MAXDAC, 0, 100));
-        break;
-    case CVTarget::Envelope1:
-        outputs[2].SetExternalTrigger(CVValue > MAXDAC / 2);
-        break;
-    case CVTarget::Envelope2:
-        outputs[3].SetExternalTrigger(CVValue > MAXDAC / 2);
-        break;
-    case CVTarget::Output3:
-        outputs[2].SetCVValue(CVValue);
-        break;
-    case CVTarget::Output4:
-        outputs[3].SetCVValue(CVValue);
-        break;
-    }
-    // Update the display if the CV target is not None
-    // if (cvTarget != CVTarget::None && menuMode == 0 && millis() - lastDisplayUpdateTime > 1000) {
-    //     displayRefresh = 1;
-    //     lastDisplayUpdateTime = millis();
-    // }
-}
-
-// External clock interrupt service routine
-void ClockReceived() {
-    unsigned long currentTime = millis();
-    // Debounce: ignore interrupts that occur too close together (less than 1ms)
-    if (currentTime - lastClockInterruptTime < 1) {
-        return;
+void ApplyReset(int, int32_t value) {
+    // Targets are only written on changes, so this is the rising edge
+    if (value) {
+        tickCounter = 0;
+        clockSync.Reset();
     }
+}
+
+void ApplyBPM(int, int32_t value) {
+    UpdateBPM(value);
+}
+
+void ApplyDivider(int output, int32_t value) {
+    outputs[output]->SetDivider(value);
+}
+
+void ApplyPulseProbability(int output, int32_t value) {
+    outputs[output]->SetPulseProbability(value);
+}
+
+void ApplySwingAmount(int output, int32_t value) {
+    outputs[output]->SetSwingAmount(value);
+}
+
+void ApplySwingEvery(int output, int32_t value) {
+    outputs[output]->SetSwingEvery(value);
+}
+
+void ApplyLevel(int output, int32_t value) {
+    dacOutputs[output - NUM_GATE_OUTS].SetLevel(value);
+}
+
+void ApplyOffset(int output, int32_t value) {
+    dacOutputs[output - NUM_GATE_OUTS].SetOffset(value);
+}
 
-    unsigned long interval = currentTime - lastClockInterruptTime;
-    lastClockInterruptTime = currentTime;
+void ApplyWaveform(int output, int32_t value) {
+    dacOutputs[output - NUM_GATE_OUTS].SetWaveformType(static_cast<WaveformType>(value));
+}
+
+void ApplyDutyCycle(int output, int32_t value) {
+    outputs[output]->SetDutyCycle(value);
+}
+
+void ApplyEnvelope(int output, int32_t value) {
+    dacOutputs[output - NUM_GATE_OUTS].SetExternalTrigger(value);
+}
+
+void ApplyQuantizerCV(int output, int32_t value) {
+    dacOutputs[output - NUM_GATE_OUTS].SetCVValue(value);
+}
 
-    // Ignore obviously wrong intervals (too short or too long)
-    if (interval < 10 || interval > 2000) {
+// How each CV target is driven, in the order of CVTarget: handler, output and range of values. Gate
+// targets follow the edges from the ADC window comparator instead of going through the matrix. The
+// values are worked out in the interrupts, but most handlers share their settings with the menu and
+// run in the main loop. Only the ones that hand a value to the render stage, or need every edge, are
+// called straight from the interrupt.
+typedef struct {
+    void (*apply)(int output, int32_t value);
+    int output;
+    int minimum;
+    int maximum;
+    bool gate;
+    bool immediate;
+} CVTargetRoute;
+
+constexpr CVTargetRoute cvTargetRoutes[] = {
+    {nullptr, 0, 0, 0},
+    {ApplyStartStop, 0, 0, 1, true},
+    {ApplyReset, 0, 0, 1, true, true},
+    {ApplyBPM, 0, minBPM, maxBPM},
+    {ApplyDivider, 0, 0, DividerAmount - 1},
+    {ApplyDivider, 1, 0, DividerAmount - 1},
+    {ApplyDivider, 2, 0, DividerAmount - 1},
+    {ApplyDivider, 3, 0, DividerAmount - 1},
+    {ApplyPulseProbability, 0, 1, 100},
+    {ApplyPulseProbability, 1, 1, 100},
+    {ApplyPulseProbability, 2, 1, 100},
+    {ApplyPulseProbability, 3, 1, 100},
+    {ApplySwingAmount, 0, 0, SwingAmountLength - 1},
+    {ApplySwingEvery, 0, 1, MaxSwingEvery},
+    {ApplySwingAmount, 1, 0, SwingAmountLength - 1},
+    {ApplySwingEvery, 1, 1, MaxSwingEvery},
+    {ApplySwingAmount, 2, 0, SwingAmountLength - 1},
+    {ApplySwingEvery, 2, 1, MaxSwingEvery},
+    {ApplySwingAmount, 3, 0, SwingAmountLength - 1},
+    {ApplySwingEvery, 3, 1, MaxSwingEvery},
+    {ApplyLevel, 2, 0, 100},
+    {ApplyLevel, 3, 0, 100},
+    {ApplyOffset, 2, 0, 100},
+    {ApplyOffset, 3, 0, 100},
+    {ApplyWaveform, 2, 0, WaveformTypeLength - 1}, // Output 3 also has the oscillator
+    {ApplyWaveform, 3, 0, WaveformTypeLength - 2},
+    {ApplyDutyCycle, 0, 0, 100},
+    {ApplyDutyCycle, 1, 0, 100},
+    {ApplyDutyCycle, 2, 0, 100},
+    {ApplyDutyCycle, 3, 0, 100},
+    {ApplyEnvelope, 2, 0, 1, true, true},
+    {ApplyEnvelope, 3, 0, 1, true, true},
+    {ApplyQuantizerCV, 2, 0, MAXDAC, false, true},
+    {ApplyQuantizerCV, 3, 0, MAXDAC, false, true},
+};
+constexpr int CVTargetRouteCount = sizeof(cvTargetRoutes) / sizeof(cvTargetRoutes[0]);
+static_assert(CVTargetRouteCount == sizeof(CVTargetDescription) / sizeof(CVTargetDescription[0]), "Every CV target needs a route");
+
+// Newest value of each target left by the interrupts for the main loop
+volatile int32_t cvTargetValues[CVTargetRouteCount];
+volatile bool cvTargetPending[CVTargetRouteCount] = {};
+
+// From the CV tick or the ADC interrupt
+void ApplyCVTarget(uint8_t target, int32_t value) {
+    const CVTargetRoute &route = cvTargetRoutes[target];
+    if (route.immediate) {
+        route.apply(route.output, value);
         return;
     }
+    cvTargetValues[target] = value;
+    cvTargetPending[target] = true;
+}
 
-    static unsigned long intervals[3] = {0, 0, 0};
-    static int intervalIndex = 0;
+// Apply the target values the interrupts left, in the main loop alongside the menu
+void HandleCVTargets() {
+    for (int target = 0; target < CVTargetRouteCount; target++) {
+        if (!cvTargetPending[target]) {
+            continue;
+        }
+        uint32_t primask = __get_PRIMASK();
+        noInterrupts();
+        int32_t value = cvTargetValues[target];
+        cvTargetPending[target] = false;
+        __set_PRIMASK(primask);
+        cvTargetRoutes[target].apply(cvTargetRoutes[target].output, value);
+    }
+}
 
-    intervals[intervalIndex] = interval;
-    intervalIndex = (intervalIndex + 1) % 3;
+// Rebuild the modulation matrix from the CV settings, the gains are worked out here and not per reading.
+// The render interrupt reads the matrix, so it is held off while the routes change, the clock
+// interrupts keep running. Inputs with a gate target are watched by the window comparator, their
+// attenuation and offset do not apply. Gates only pass on edges, so the start/stop target is set to
+// the level of its input here, and a CV held low at power up keeps the clock stopped.
+void UpdateModRoutes() {
+    bool renderEnabled = NVIC->ISER[0] & (1 << TC3_IRQn);
+    NVIC_DisableIRQ(TC3_IRQn);
+    modMatrix.Clear();
+    for (int i = 0; i < NUM_CV_INS; i++) {
+        bool gate = false;
+        for (int j = 0; j < CV_ROUTES; j++) {
+            CVTarget target = CVInputTarget[i][j];
+            const CVTargetRoute &route = cvTargetRoutes[target];
+            if (route.gate) {
+                gate = true;
+            } else if (target != CVTarget::None) {
+                modMatrix.AddRoute(i, target, CVInputAttenuation[i][j], CVInputOffset[i][j], route.minimum, route.maximum);
+            }
+        }
+        SetADCGateInput(i, gate);
+        for (int j = 0; j < CV_ROUTES; j++) {
+            if (CVInputTarget[i][j] == CVTarget::StartStop) {
+                ApplyCVTarget(CVTarget::StartStop, GetADCGateState(i));
+            }
+        }
+    }
+    if (renderEnabled) {
+        NVIC_EnableIRQ(TC3_IRQn);
+    }
+}
 
-    // Calculate average interval, excluding outliers
-    unsigned long averageInterval = 0;
-    int validIntervals = 0;
-    for (int i = 0; i < 3; i++) {
-        if (intervals[i] > 0 && abs((long)intervals[i] - (long)interval) < interval / 2) {
-            averageInterval += intervals[i];
-            validIntervals++;
+// Edge on a CV input used as a gate, from the ADC interrupt or the CV tick
+void CVGateChanged(int input, bool state) {
+    for (int j = 0; j < CV_ROUTES; j++) {
+        CVTarget target = CVInputTarget[input][j];
+        if (cvTargetRoutes[target].gate) {
+            ApplyCVTarget(target, state);
         }
     }
+}
 
-    if (validIntervals > 0) {
-        averageInterval /= validIntervals;
-    } else {
+// External clock interrupt service routine, the edges come timestamped from the capture timer
+void ClockReceived() {
+    unsigned long timestamp;
+    while (ReadClockCapture(timestamp)) {
+        ClockEdge(timestamp);
+    }
+}
+
+// Process one external clock edge
+void ClockEdge(unsigned long timestamp) {
+    // Edge spacing at the tempo limits for the selected number of input pulses per beat
+    unsigned long pulsesPerBeat = externalClockDividers[externalDividerIndex];
+    unsigned long minInterval = 60000000UL / maxBPM / pulsesPerBeat;
+    unsigned long maxInterval = 60000000UL / minExternalBPM / pulsesPerBeat;
+
+    unsigned long interval = timestamp - lastClockEdgeTime;
+    // Debounce: ignore edges closer than half a pulse at the fastest tempo
+    if (interval < minInterval / 2) {
         return;
     }
+    lastClockEdgeTime = timestamp;
+    lastClockInterruptTime = micros();
+
+    // After a long gap the clock was stopped or replugged, lock onto it again from scratch
+    if (interval > maxInterval) {
+        clockSync.Unlock();
+    }
 
-    // Divide the external clock signal by the selected divider
-    if (externalTickCounter % externalClockDividers[externalDividerIndex] == 0) {
-        if (averageInterval > 0) {
-            clockInterval = averageInterval;
-            unsigned int newBPM = 60000 / (averageInterval * externalClockDividers[externalDividerIndex]);
-            // Add hysteresis to BPM changes
-            if (abs(newBPM - BPM) > 3) {
-                UpdateBPM(newBPM);
-                displayRefresh = 1;
-                DEBUG_PRINT("External clock connected");
+    clockSync.SetTicksPerPulse(PPQN / pulsesPerBeat);
+    long jump = clockSync.Edge(timestamp, tickCounter);
+    if (jump != ClockSync::NoJump) {
+        tickCounter = jump;
+        // The outputs line up on tick 0 by themselves, any other jump needs an explicit resync
+        if (jump != 0) {
+            for (int i = 0; i < NUM_OUTPUTS; i++) {
+                outputs[i]->Resync();
             }
         }
-
-        // Update outputs
-        noInterrupts(); // Critical section
-        for (int i = 0; i < NUM_OUTPUTS; i++) {
-            outputs[i].SetExternalClock(true);
-            outputs[i].IncrementInternalCounter();
+    }
+    tickLimit = clockSync.GetTickLimit();
+
+    // Follow the filtered clock period instead of restarting the ticks on every beat
+    if (clockSync.IsLocked()) {
+        if (!usingExternalClock) {
+            lastInternalBPM = BPM;
+            usingExternalClock = true;
+            DEBUG_PRINT("External clock connected");
         }
-        usingExternalClock = true;
-        tickCounter = 0;
-        interrupts();
+        SetTickPeriod(clockSync.GetTickPeriod());
     }
-    externalTickCounter++;
 }
 
 // Called on loop to check if the external clock is still connected and revert to internal clock if not
 void HandleExternalClock() {
-    unsigned long currentTime = millis();
-    if (usingExternalClock && (currentTime - lastClockInterruptTime) > 2000) {
+    unsigned long currentTime = micros();
+    // No edge for a whole beat at the slowest tempo means the clock is gone
+    if (usingExternalClock && (currentTime - lastClockInterruptTime) > 60000000UL / minExternalBPM) {
         usingExternalClock = false;
+        clockSync.Unlock();
         BPM = lastInternalBPM;
         UpdateBPM(BPM);
-        for (int i = 0; i < NUM_OUTPUTS; i++) {
-            outputs[i].SetExternalClock(false);
-        }
         displayRefresh = 1;
         DEBUG_PRINT("External clock disconnected");
+        return;
+    }
+
+    // Show the tempo of the external clock, the tick timer is already running at it
+    if (usingExternalClock && clockSync.GetPulsePeriod() > 0) {
+        unsigned int newBPM = 60000000UL / (clockSync.GetPulsePeriod() * externalClockDividers[externalDividerIndex]);
+        newBPM = constrain(newBPM, minBPM, maxBPM);
+        // Add hysteresis to BPM changes
+        if (abs(int(newBPM) - int(BPM)) > 1) {
+            BPM = newBPM;
+            displayRefresh = 1;
+        }
     }
 }
 
 // Set the hardware timer based on the BPM
 void UpdateBPM(unsigned int newBPM) {
     BPM = constrain(newBPM, minBPM, maxBPM);
-    TimerTcc0.setPeriod(60L * 1000 * 1000 / BPM / PPQN / 4);
+    // The external clock sets the tick timer while it is connected
+    if (usingExternalClock) {
+        return;
+    }
+    SetTickPeriod(60.0f * 1000 * 1000 / BPM / PPQN);
+}
+
+// Set the hardware timer to the tick length in microseconds
+void SetTickPeriod(float period) {
+    tickPeriod = period;
+    TimerTcc0.setPeriod(period / 4);
 }
 
 void HandleOutputs() {
-    for (int i = 0; i < NUM_OUTPUTS; i++) {
-        // Set the output level based on the pulse state
-        SetPin(i, outputs[i].GetOutputLevel());
+    // The gates are written by the clock interrupt and the MCP4725 by the render interrupt,
+    // only the internal DAC is updated here unless it is streaming audio
+    if (!dacOutputs[0].IsAudioRunning()) {
+        SetPin(2, dacOutputs[0].GetOutputLevel());
+    }
+}
+
+void ClockPulse() { // Inside the interrupt
+    // Never run ahead of the external clock, wait for its next edge instead
+    if (!usingExternalClock || tickCounter < tickLimit) {
+        for (int i = 0; i < NUM_GATE_OUTS; i++) {
+            gateOutputs[i].Pulse(PPQN, tickCounter);
+        }
+        for (int i = 0; i < NUM_DAC_OUTS; i++) {
+            dacOutputs[i].Pulse(PPQN, tickCounter);
+        }
+        tickCounter++;
+    }
+    UpdateGates();
+}
 
-        if (i == 2 || i == 3) {
-            // Set the output level based on the pulse state
-            outputs[i].GenEnvelope();
+// Write the gate jacks from the clock interrupt. Each pulse goes high on its tick and the one-shot
+// gate timer ends it after the exact pulse width, pulses too long for the timer end on the tick.
+void UpdateGates() {
+    for (int i = 0; i < NUM_GATE_OUTS; i++) {
+        bool state = gateOutputs[i].GetPulseState();
+        uint8_t starts = gateOutputs[i].GetPulseStarts();
+        bool started = (starts != gatePulseStarts[i]);
+        gatePulseStarts[i] = starts;
+        if (started && state) {
+            WriteGate(i, true);
+            StartGateTimer(i, gateTimerCounts[i]);
+        } else if (!state && !IsGateTimerRunning(i)) {
+            WriteGate(i, false);
         }
     }
 }
 
-void ClockPulse() { // Inside the interrupt
-    for (int i = 0; i < NUM_OUTPUTS; i++) {
-        outputs[i].Pulse(PPQN, tickCounter);
+// Work out the gate widths in timer counts when a schedule or the tick length changed, so the tick
+// interrupt only loads them and stays free of software float
+void UpdateGateLengths() {
+    float period = tickPeriod;
+    bool periodChanged = (period != gateTickPeriod);
+    gateTickPeriod = period;
+    for (int i = 0; i < NUM_GATE_OUTS; i++) {
+        uint8_t version = gateOutputs[i].GetScheduleVersion();
+        if (periodChanged || version != gateScheduleVersion[i]) {
+            gateScheduleVersion[i] = version;
+            gateTimerCounts[i] = GateTimerCounts(i, gateOutputs[i].GetPulseTicks(PPQN) * period);
+        }
+    }
+}
+
+void RenderOutputs() { // Inside the lower priority render interrupt
+    for (int i = 0; i < NUM_GATE_OUTS; i++) {
+        gateOutputs[i].Render(PPQN);
+    }
+    UpdateGateLengths();
+    for (int i = 0; i < NUM_DAC_OUTS; i++) {
+        dacOutputs[i].Render(PPQN);
+        // Envelopes advance on the same fixed control tick
+        dacOutputs[i].GenEnvelope();
+    }
+
+    // The MCP4725 is written at the control rate, the DMA driver fits it in between display chunks
+    SetPin(3, dacOutputs[1].GetOutputLevel());
+    // Each control tick is one I2C budget period, the display gets one chunk of it
+    RefillI2CBudget();
+
+    RenderAudio();
+
+    // CV inputs at their own fixed rate, so the modulation never depends on the main loop
+    if (++cvTickCounter >= CONTROL_RATE / CV_RATE) {
+        cvTickCounter = 0;
+        HandleCVInputs();
+    }
+}
+
+// Keep the audio stream on the internal DAC fed, it starts and stops with the oscillator waveform
+void RenderAudio() {
+    if (!dacOutputs[0].IsAudioRunning() || tickPeriod == 0.0f) {
+        StopAudioDAC();
+        return;
+    }
+    StartAudioDAC();
+    float ticksPerSample = 1000000.0f / AUDIO_SAMPLE_RATE / tickPeriod;
+    int block;
+    while ((block = NextAudioBlock()) >= 0) {
+        dacOutputs[0].FillAudioBlock(PPQN, ticksPerSample, audioBlocks[block], AUDIO_BLOCK_SIZE);
+        AudioBlockFilled(block);
     }
-    tickCounter++;
 }
 
 void UpdateParameters(LoadSaveParams p) {
@@ -1910,28 +1775,47 @@ void UpdateParameters(LoadSaveParams p) {
     externalDividerIndex = p.externalClockDivIdx;
     // Serial.println(p.divIdx[0]);
     for (int i = 0; i < NUM_OUTPUTS; i++) {
-        outputs[i].SetDivider(p.divIdx[i]);
-        outputs[i].SetDutyCycle(p.dutyCycle[i]);
-        outputs[i].SetOutputState(p.outputState[i]);
-        outputs[i].SetLevel(p.outputLevel[i]);
-        outputs[i].SetOffset(p.outputOffset[i]);
-        outputs[i].SetSwingAmount(p.swingIdx[i]);
-        outputs[i].SetSwingEvery(p.swingEvery[i]);
-        outputs[i].SetPulseProbability(p.pulseProbability[i]);
-        outputs[i].SetEuclideanParams(p.euclideanParams[i]);
-        outputs[i].SetPhase(p.phaseShift[i]);
-        outputs[i].SetWaveformType(static_cast<WaveformType>(p.waveformType[i]));
-        outputs[i].SetEnvelopeParams(p.envParams[i]);
-        outputs[i].SetQuantizerParams(p.quantizerParams[i]);
+        outputs[i]->SetDivider(p.divIdx[i]);
+        outputs[i]->SetDutyCycle(p.dutyCycle[i]);
+        outputs[i]->SetOutputState(p.outputState[i]);
+        outputs[i]->SetSwingAmount(p.swingIdx[i]);
+        outputs[i]->SetSwingEvery(p.swingEvery[i]);
+        outputs[i]->SetPulseProbability(p.pulseProbability[i]);
+        outputs[i]->SetEuclideanParams(p.euclideanParams[i]);
+        outputs[i]->SetPhase(p.phaseShift[i]);
+    }
+    for (int i = 0; i < NUM_DAC_OUTS; i++) {
+        dacOutputs[i].SetLevel(p.outputLevel[NUM_GATE_OUTS + i]);
+        dacOutputs[i].SetOffset(p.outputOffset[NUM_GATE_OUTS + i]);
+        dacOutputs[i].SetWaveformType(static_cast<WaveformType>(p.waveformType[NUM_GATE_OUTS + i]));
+        dacOutputs[i].SetEnvelopeParams(p.envParams[NUM_GATE_OUTS + i]);
+        dacOutputs[i].SetQuantizerParams(p.quantizerParams[NUM_GATE_OUTS + i]);
     }
     for (int i = 0; i < NUM_CV_INS; i++) {
-        CVInputTarget[i] = static_cast<CVTarget>(p.CVInputTarget[i]);
-        CVInputAttenuation[i] = p.CVInputAttenuation[i];
-        CVInputOffset[i] = p.CVInputOffset[i];
+        for (int j = 0; j < CV_ROUTES; j++) {
+            CVInputTarget[i][j] = static_cast<CVTarget>(p.CVInputTarget[i][j]);
+            CVInputAttenuation[i][j] = p.CVInputAttenuation[i][j];
+            CVInputOffset[i][j] = p.CVInputOffset[i][j];
+        }
+    }
+    UpdateModRoutes();
+}
+
+// Seed the random generators of the outputs
+void SeedRandom() {
+    uint32_t seed = RANDOM_SEED;
+    if (seed == 0) {
+        // Gather the noise in the ADC readings and the boot timing
+        for (int i = 0; i < 32; i++) {
+            seed = (seed << 1) ^ GetADCSample(i % NUM_CV_INS, i / NUM_CV_INS) ^ micros();
+        }
+    }
+    for (int i = 0; i < NUM_OUTPUTS; i++) {
+        outputs[i]->SetRandomSeed(seed);
     }
 }
 
-// Initialize the hardware timer
+// Initialize the hardware timers
 void InitializeTimer() {
     // Set up the timer
     TimerTcc0.initialize();
@@ -1939,6 +1823,11 @@ void InitializeTimer() {
 
     // Set high priority for the timer interrupt if your platform supports it
     NVIC_SetPriority(TCC0_IRQn, 0); // Highest priority (0)
+
+    // The waveforms and envelopes are rendered at a fixed rate below the clock, encoder and I2C interrupts
+    TimerTc3.initialize(1000000 / CONTROL_RATE);
+    TimerTc3.attachInterrupt(RenderOutputs);
+    NVIC_SetPriority(TC3_IRQn, 2);
 }
 
 void setup() {
@@ -1947,6 +1836,9 @@ void setup() {
 
     // Initialize I/O (DAC, pins, etc.)
     InitIO();
+    InitADCGates(CVGateChanged);
+    SeedRandom();
+    InitMenu();
 
     // Initialize OLED display with address 0x3C for 128x64
     if (!display.begin(SSD1306_SWITCHCAPVCC, OLED_ADDRESS)) {
@@ -1954,7 +1846,7 @@ void setup() {
         for (;;)
             ; // Don't proceed, loop forever
     }
-    Wire.setClock(1000000);
+    Wire.setClock(I2C_CLOCK);
     display.clearDisplay();
     display.setTextWrap(false);
     display.cp437(true); // Use full 256 char 'Code Page 437' font
@@ -1975,8 +1867,13 @@ void setup() {
     display.display();
     delay(1500);
 
-    // Attach interrupt for external clock
-    attachInterrupt(digitalPinToInterrupt(CLK_IN_PIN), ClockReceived, RISING);
+    // From here on the DAC and display are sent by DMA in the background
+    InitI2CDMA(display.getBuffer());
+    InitAudioDAC();
+    dacOutputs[0].SetAudioCapable(true);
+
+    // Timestamp the external clock in hardware
+    InitClockCapture(ClockReceived);
 
     // Load settings from flash memory (slot 0) or set defaults
     LoadSaveParams p = Load(0);
@@ -1984,6 +1881,7 @@ void setup() {
 
     // Initialize timer
     InitializeTimer();
+    InitGateTimers();
     UpdateBPM(BPM);
 }
 
@@ -1995,14 +1893,13 @@ void HandleIO() {
 
     HandleOutputs();
 
-    HandleCVInputs();
-
     HandleExternalClock();
 }
 
 // Main loop
 void loop() {
     HandleIO();
+    HandleCVTargets();
 
     // Only handle display every few frames
     if (frameSkip == 0) {
@@ -0,0 +1,24 @@
+#pragma once
+
+// Table driven menu dispatch. Every item is described by an entry of handlers and every page by a draw
+// function over a run of consecutive items, so the encoder dispatches straight into the entry of the
+// current item. The entries hold no labels or ranges: the handlers keep the limits of their parameter
+// and the page functions lay out and label their items. Handlers that act on a single item ignore
+// their index.
+typedef struct {
+    void (*adjust)(int index, int direction); // Encoder turned while the item is edited, direction is -1 or 1
+    void (*select)(int index);                // Clicked, for items without an edit mode
+    void (*enter)(int index);                 // Edit mode opened, optional
+    void (*exit)(int index);                  // Edit mode closed, optional
+    bool unsaved;                             // Changes belong to the saved settings
+} MenuEntry;
+
+typedef struct {
+    int items;
+    void (*draw)(int firstItem, int items);
+} MenuPage;
+
+// Sum of the items on the pages, checked against the entries at compile time
+constexpr int MenuPageItems(const MenuPage *pages, int count) {
+    return count == 0 ? 0 : pages->items + MenuPageItems(pages + 1, count - 1);
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <Arduino.h>
+
+// Routes per CV input, each with its own target, attenuation and offset. Both inputs together fill
+// the matrix, so one LFO can drive several outputs and their swing at once.
+#define CV_ROUTES 4
+// Full scale of the CV readings
+#define MOD_INPUT_MAX 4095
+
+// CV modulation matrix. Each route takes one CV input to one target through a fixed-point gain and bias,
+// worked out once when the route is set up, and then onto the target's range of values. Inputs are
+// processed with a loop over the routes, and a target is only written when its value actually changes.
+class ModMatrix {
+  public:
+    static int const MaxRoutes = 8;
+    static int32_t const NoValue = INT32_MIN;
+
+    typedef struct {
+        uint8_t input;
+        uint8_t target;
+        int32_t scale;   // Q15 gain, 32768 is unity
+        int32_t bias;    // Added after the gain, in input units
+        int32_t minimum; // Target value for the lowest input
+        int32_t steps;   // Number of target values the input range is divided into
+        int32_t last;    // Value last written to the target
+    } Route;
+
+    void Clear() { _routeCount = 0; }
+
+    // Route an input to a target taking the values minimum to maximum. Attenuation and offset are
+    // percentages as set on the CV page. Returns false when all routes are taken.
+    bool AddRoute(uint8_t input, uint8_t target, int attenuation, int offset, int minimum, int maximum) {
+        if (_routeCount >= MaxRoutes) {
+            return false;
+        }
+        Route &route = _routes[_routeCount++];
+        route.input = input;
+        route.target = target;
+        route.scale = (100 - constrain(attenuation, 0, 100)) * 32768 / 100;
+        route.bias = constrain(offset, 0, 100) * MOD_INPUT_MAX / 100;
+        route.minimum = minimum;
+        route.steps = maximum - minimum + 1;
+        route.last = NoValue;
+        return true;
+    }
+
+    int GetRouteCount() { return _routeCount; }
+    const Route &GetRoute(int index) { return _routes[index]; }
+
+    // Target value of a route for an input reading
+    static int32_t Evaluate(const Route &route, int32_t cv) {
+        int32_t value = ((cv * route.scale) >> 15) + route.bias;
+        value = constrain(value, 0, MOD_INPUT_MAX);
+        // Equal slices of the input range for each target value
+        return route.minimum + ((value * route.steps) >> 12);
+    }
+
+    // Evaluate the routes of an input, apply(target, value) is called for every route whose value changed
+    template <typename Apply>
+    void Process(uint8_t input, int32_t cv, Apply apply) {
+        for (int i = 0; i < _routeCount; i++) {
+            Route &route = _routes[i];
+            if (route.input != input) {
+                continue;
+            }
+            int32_t value = Evaluate(route, cv);
+            if (value != route.last) {
+                route.last = value;
+                apply(route.target, value);
+            }
+        }
+    }
+
+  private:
+    Route _routes[MaxRoutes];
+    int _routeCount = 0;
+};
@@ -2,12 +2,19 @@
 #include <Arduino.h>
 
 #include "euclidean.hpp"
+#include "random.hpp"
 #include "utils.hpp"
+#include "wavetables.hpp"
+
+// Rate in Hz of the render stage and the envelope generators
+#define CONTROL_RATE 2000
+// Size of the buffers the value descriptions are written into
+#define DESCRIPTION_LENGTH 12
 
 #include "quantizer.cpp"
 #include "scales.cpp"
 
-// Define a type for the DAC output type
+// Kinds of output, the Output class is specialized for each
 enum OutputType {
     DigitalOut = 0,
     DACOut = 1,
@@ -33,9 +40,10 @@ enum WaveformType {
     AREnvelope,
     ADSREnvelope,
     QuantizeInput,
+    Oscillator, // Audio rate, only on the output wired to the internal DAC
 };
 
-String WaveformTypeDescriptions[] = {
+char const *const WaveformTypeDescriptions[] = {
     "Square",
     "Triangle",
     "Sine",
@@ -54,8 +62,34 @@ String WaveformTypeDescriptions[] = {
     "AR Env",
     "ADSR Env",
     "Quantize",
+    "Osc",
 };
-int WaveformTypeLength = sizeof(WaveformTypeDescriptions) / sizeof(WaveformTypeDescriptions[0]);
+int const WaveformTypeLength = sizeof(WaveformTypeDescriptions) / sizeof(WaveformTypeDescriptions[0]);
+
+char const *const DividerDescriptions[] = {"/128", "/64", "/32", "/16", "/8", "/4", "/3", "/2", "/1.5", "x1", "x1.5", "x2", "x3", "x4", "x8", "x16", "x24", "x32", "Env"};
+char const *const SwingAmountDescriptions[] = {"0", "2/96", "4/96", "6/96", "8/96", "10/96", "12/96"};
+int const DividerAmount = sizeof(DividerDescriptions) / sizeof(DividerDescriptions[0]);
+int const SwingAmountLength = sizeof(SwingAmountDescriptions) / sizeof(SwingAmountDescriptions[0]);
+int const MaxSwingEvery = 16;
+
+// Write a whole percentage into a description buffer. Percentages stay within -100% to 100%, capping
+// the value far outside that lets the compiler see that the text always fits.
+const char *PercentDescription(char *buffer, int value) {
+    snprintf(buffer, DESCRIPTION_LENGTH, "%d%%", int16_t(constrain(value, -999, 999)));
+    return buffer;
+}
+
+// Write a time, in milliseconds up to 999 ms and in seconds with one decimal above. Envelope times end
+// at 10 s, capping the value far above that lets the compiler see that the text always fits.
+const char *TimeDescription(char *buffer, float ms) {
+    if (ms > 999) {
+        uint16_t tenths = uint16_t(min(ms, 99999.0f) / 100.0f + 0.5f);
+        snprintf(buffer, DESCRIPTION_LENGTH, "%u.%us", tenths / 10u, tenths % 10u);
+    } else {
+        snprintf(buffer, DESCRIPTION_LENGTH, "%ums", uint16_t(max(ms, 0.0f) + 0.5f));
+    }
+    return buffer;
+}
 
 // ADSR envelope parameters
 typedef struct {
@@ -69,6 +103,33 @@ typedef struct {
     bool retrigger;     // Retrigger on gate high
 } EnvelopeParams;
 
+// Edge events flagged by the clock ISR and applied by the render stage
+enum TickEvent : uint8_t {
+    TickIdle = 0, // No edge on this tick
+    TickStart,    // Pulse triggered
+    TickSkip,     // Pulse skipped by probability or an inactive Euclidean step
+    TickStop,     // End of the pulse duty cycle
+};
+
+// Output clock ratio against the master clock, kept as a fraction so every ratio is exact
+typedef struct {
+    uint8_t multiplier;
+    uint8_t divisor;
+} ClockRatio;
+
+// Output timing precomputed from the divider, duty cycle, phase and swing, so the clock ISR only reads integers.
+// Phases are fractions of a 32-bit turn, one turn being one output period.
+typedef struct {
+    ClockRatio ratio;
+    uint32_t increment;   // Whole phase step per tick
+    uint32_t remainder;   // Fractional phase step per tick, in 1/modulus
+    uint32_t modulus;     // Ticks per period times the multiplier
+    uint32_t offsetPhase; // Pulse start
+    uint32_t dutyPhase;   // Pulse length
+    uint32_t swingPhase;  // Delay of the swung pulses
+    int swingEvery;       // Swing every x periods
+} PulseSchedule;
+
 typedef struct {
     bool enable;
     int octaveShift;
@@ -77,79 +138,83 @@ typedef struct {
     int noteIndex;
 } QuantizerParams;
 
-class Output {
+// Timing core shared by both kinds of output: the phase accumulator and its schedule, divider, duty cycle,
+// phase, swing, probability and Euclidean rhythm. A gate output is this core and nothing more, the DAC
+// outputs add the waveform generators on top. Nothing is virtual, the menus reach the common settings of
+// any output through this class while the per tick calls go to the specialized outputs directly.
+class OutputCore {
   public:
-    // Constructor
-    Output(int ID, OutputType type);
-
     // Pulse State
-    void Pulse(int PPQN, unsigned long tickCounter);
-    void GeneratePulse(int PPQN, unsigned long tickCounter);
-    void GenEnvelope();
+    TickEvent GeneratePulse();
     bool GetPulseState() { return _isPulseOn; }
+    uint8_t GetPulseStarts() { return _pulseStarts; } // Counts the pulses started by the clock ISR
     void SetPulse(bool state) { _isPulseOn = state; }
     void TogglePulse() { _isPulseOn = !_isPulseOn; }
     bool HasPulseChanged();
-    void SetExternalClock(bool state) { _externalClock = state; }
-    void IncrementInternalCounter() { _internalPulseCounter++; }
+    void Resync() { _resyncPending = true; } // Line the phase up with the tick count on the next tick
+    void SetRandomSeed(uint32_t seed) { _random.SetSeed(seed + _ID); } // Each output gets its own sequence
 
     // Output State
     bool GetOutputState() { return _state; }
     void SetOutputState(bool state) { _state = state; }
     void ToggleOutputState() { _state = !_state; }
-    void ToggleMasterState();
-    void SetMasterState(bool state);
 
     // Divider
     int GetDividerIndex() { return _dividerIndex; }
     void SetDivider(int index) {
-        if (_outputType == OutputType::DigitalOut && index >= _dividerAmount - 1) {
-            // Skip envelope type for digital outputs
-            index = _dividerAmount - 2; // Set to the second-to-last divider
-        }
-        _dividerIndex = constrain(index, 0, _dividerAmount - 1);
+        _dividerIndex = constrain(index, 0, _lastDivider);
+        _scheduleDirty = true;
     }
-    String GetDividerDescription() { return _dividerDescription[_dividerIndex]; }
+    const char *GetDividerDescription() { return DividerDescriptions[_dividerIndex]; }
     int GetDividerAmounts() { return _dividerAmount; }
+    uint8_t GetScheduleVersion() { return _scheduleVersion; } // Changes whenever a new schedule is swapped in
+    // Pulse width in master ticks, as the clock ISR currently times it
+    float GetPulseTicks(int PPQN) {
+        const PulseSchedule &schedule = _schedules[_activeSchedule];
+        if (schedule.ratio.multiplier == 0) {
+            return 0.0f;
+        }
+        return schedule.dutyPhase / 4294967296.0f * PPQN * schedule.ratio.divisor / schedule.ratio.multiplier;
+    }
 
     // Duty Cycle
     int GetDutyCycle() { return _dutyCycle; }
-    void SetDutyCycle(int dutyCycle) { _dutyCycle = constrain(dutyCycle, 1, 99); }
-    String GetDutyCycleDescription() { return String(_dutyCycle) + "%"; }
-
-    // Output Level
-    uint32_t GetLevel() { return _level; }
-    uint32_t GetOutputLevel(); // Output Level based on the output type
-    void QuantizerCVValue(float CVValue);
-    String GetLevelDescription() { return String(_level) + "%"; }
-    void SetLevel(int level) { _level = constrain(level, 0, 100); }
-
-    // Output Offset
-    int GetOffset() { return _offset; }
-    void SetOffset(int offset) { _offset = constrain(offset, 0, 100); }
-    String GetOffsetDescription() { return String(_offset) + "%"; }
+    void SetDutyCycle(int dutyCycle) {
+        _dutyCycle = constrain(dutyCycle, 1, 99);
+        _scheduleDirty = true;
+    }
+    const char *GetDutyCycleDescription(char *buffer) { return PercentDescription(buffer, _dutyCycle); }
 
     // Swing
-    void SetSwingAmount(int swingAmount) { _swingAmountIndex = constrain(swingAmount, 0, 6); }
+    void SetSwingAmount(int swingAmount) {
+        _swingAmountIndex = constrain(swingAmount, 0, 6);
+        _scheduleDirty = true;
+    }
     int GetSwingAmountIndex() { return _swingAmountIndex; }
     int GetSwingAmounts() { return _swingAmount; }
-    String GetSwingAmountDescription() { return _swingAmountDescriptions[_swingAmountIndex]; }
-    void SetSwingEvery(int swingEvery) { _swingEvery = constrain(swingEvery, 1, _swingEveryAmount); }
+    const char *GetSwingAmountDescription() { return SwingAmountDescriptions[_swingAmountIndex]; }
+    void SetSwingEvery(int swingEvery) {
+        _swingEvery = constrain(swingEvery, 1, _swingEveryAmount);
+        _scheduleDirty = true;
+    }
     int GetSwingEvery() { return _swingEvery; }
     int GetSwingEveryAmounts() { return _swingEveryAmount; }
 
     // Pulse Probability
     void SetPulseProbability(int pulseProbability) { _pulseProbability = constrain(pulseProbability, 0, 100); }
     int GetPulseProbability() { return _pulseProbability; }
-    String GetPulseProbabilityDescription() { return String(_pulseProbability) + "%"; }
+    const char *GetPulseProbabilityDescription(char *buffer) { return PercentDescription(buffer, _pulseProbability); }
 
     // Euclidean Rhythm
     EuclideanParams GetEuclideanParams() { return _euclideanParams; }
-    void SetEuclideanParams(EuclideanParams params) { _euclideanParams = params; }
+    void SetEuclideanParams(EuclideanParams params) {
+        _euclideanParams = params;
+        _euclideanRhythm = GeneratePattern(_euclideanParams);
+    }
     void SetEuclidean(bool euclidean);
     void ToggleEuclidean() { SetEuclidean(!_euclideanParams.enabled); }
     bool GetEuclidean() { return _euclideanParams.enabled; }
-    int GetRhythmStep(int i) { return _euclideanRhythm[i]; }
+    int GetRhythmStep(int i) { return PatternStep(_euclideanRhythm, i); }
     void SetEuclideanSteps(int steps);
     int GetEuclideanSteps() { return _euclideanParams.steps; }
     void SetEuclideanTriggers(int triggers);
@@ -160,15 +225,174 @@ class Output {
     int GetEuclideanPadding() { return _euclideanParams.pad; }
 
     // Phase
-    void SetPhase(int phase) { _phase = constrain(phase, 0, 100); }
+    void SetPhase(int phase) {
+        _phase = constrain(phase, 0, 100);
+        _scheduleDirty = true;
+    }
     int GetPhase() { return _phase; }
-    String GetPhaseDescription() { return String(_phase) + "%"; }
+    const char *GetPhaseDescription(char *buffer) { return PercentDescription(buffer, _phase); }
+
+  protected:
+    // Only built as part of one of the outputs, lastDivider is the highest divider index it takes
+    OutputCore(int ID, int lastDivider);
+
+    // Constants
+    static int const _dividerAmount = 19;
+    // Env has no clock edges, the envelope is driven by the trigger input instead
+    static constexpr ClockRatio _clockRatios[_dividerAmount] = {{1, 128}, {1, 64}, {1, 32}, {1, 16}, {1, 8}, {1, 4}, {1, 3}, {1, 2}, {2, 3}, {1, 1}, {3, 2}, {2, 1}, {3, 1}, {4, 1}, {8, 1}, {16, 1}, {24, 1}, {32, 1}, {0, 1}};
+    static int const MaxEuclideanSteps = 64;
+
+    // The shuffle of the TR-909 delays each even-numbered 1/16th by 2/96 of a beat for shuffle setting 1,
+    // 4/96 for 2, 6/96 for 3, 8/96 for 4, 10/96 for 5 and 12/96 for 6.
+    static int const _swingAmount = 7;
+    static constexpr uint8_t _swingAmounts[_swingAmount] = {0, 2, 4, 6, 8, 10, 12};
+    static int const _swingEveryAmount = MaxSwingEvery; // Max swing every value
+
+    // Variables
+    int _ID;
+    uint8_t _lastDivider;         // Highest divider index for this kind of output
+    int _dividerIndex = 9;        // Default to 1
+    int _dutyCycle = 50;          // Default to 50%
+    int _phase = 0;               // Phase offset, default to 0% (in phase with master)
+    bool _isPulseOn = false;      // Pulse state
+    bool _lastPulseState = false; // Last pulse state
+    bool _state = true;           // Output state
+    bool _oldState = true;        // Previous output state (for master stop)
+    bool _masterState = true;     // Master output state
+    int _pulseProbability = 100;  // % chance of pulse
+    Xorshift32 _random;           // Random source for probability, noise and S&H
+
+    // Phase accumulator, one full turn of the 32-bit word is one output period
+    volatile uint32_t _phaseAccumulator = 0;
+    uint32_t _phaseRemainder = 0;         // Fraction of the increment carried between ticks
+    unsigned long _cycleCount = 0;        // Periods started, used to pick the swung ones
+    uint32_t _pulseStartPhase = 0;        // Phase at which the current pulse started
+    bool _pulsePending = false;           // Pulse started and waiting for the end of its duty cycle
+    bool _swingPending = false;           // Period started but its pulse is delayed by swing
+    volatile bool _resyncPending = false; // Tick count jumped, resync the phase on the next tick
+    volatile uint8_t _pulseStarts = 0;    // Pulses started, lets the gate writer see back to back pulses
+
+    // No phase steps and so no edges, until the render stage builds the first real schedule
+    static constexpr PulseSchedule IdleSchedule = {
+        .ratio = {0, 1},
+        .increment = 0,
+        .remainder = 0,
+        .modulus = 1,
+        .offsetPhase = 0,
+        .dutyPhase = 0,
+        .swingPhase = 0,
+        .swingEvery = 1,
+    };
+
+    // Schedules are double buffered, the render stage rebuilds the spare one and then swaps it in
+    PulseSchedule _schedules[2] = {IdleSchedule, IdleSchedule};
+    volatile uint8_t _activeSchedule = 0;
+    volatile bool _scheduleDirty = true;
+    uint8_t _scheduleVersion = 0;
+
+    // Swing variables
+    int _swingEvery = 2;                // Swing every x notes
+    unsigned int _swingAmountIndex = 0; // Swing amount index
+
+    // Euclidean rhythm variables
+    int _euclideanStepIndex = 0; // Current step in the pattern
+    EuclideanParams _euclideanParams = {
+        .enabled = false,
+        .steps = 10,   // Number of steps in the pattern
+        .triggers = 6, // Number of triggers in the pattern
+        .rotation = 1, // Rotation of the pattern
+        .pad = 0,      // No trigger steps added to the end of the pattern
+    };
+    EuclideanPattern _euclideanRhythm = 0; // Euclidean rhythm pattern
+
+    // -------------- Protected Functions --------------
+
+    TickEvent AdvancePhase(int PPQN, unsigned long tick);
+    void ResyncPhase(int PPQN, ClockRatio ratio, unsigned long tick);
+    void UpdateSchedule(int PPQN);
+    bool ChangeMasterState(bool state);
+
+    // Roll the probability and Euclidean step of a pulse start, counting the pulses that go ahead
+    TickEvent TriggerPulse() {
+        TickEvent event = GeneratePulse();
+        if (event == TickEvent::TickStart) {
+            _pulseStarts++;
+        }
+        return event;
+    }
+
+    // Length of the output period in ticks, as the clock ISR currently times it
+    float PeriodTicks() {
+        const PulseSchedule &schedule = _schedules[_activeSchedule];
+        return schedule.ratio.multiplier ? float(schedule.modulus) / schedule.ratio.multiplier : 0.0f;
+    }
+};
+
+// Outputs are specialized on their kind at compile time, so each one only carries the state and the
+// tick path it needs
+template <OutputType Type>
+class Output;
+
+// Gate output, a square pulse straight from the timing core
+template <>
+class Output<OutputType::DigitalOut> : public OutputCore {
+  public:
+    // Gates have no envelope, so the last divider is skipped
+    Output(int ID) : OutputCore(ID, _dividerAmount - 2) {}
+
+    // Pulse State
+    void Pulse(int PPQN, unsigned long tickCounter); // Timing stage, called from the clock ISR
+    void Render(int PPQN);                           // Render stage, called at the control rate
+    uint32_t GetOutputLevel() { return _isPulseOn ? HIGH : LOW; }
+
+    // Output State
+    void ToggleMasterState() { SetMasterState(!_masterState); }
+    void SetMasterState(bool state) { ChangeMasterState(state); }
+};
+
+// DAC output, the timing core driving the waveform generators, envelopes, quantizer and audio oscillator
+template <>
+class Output<OutputType::DACOut> : public OutputCore {
+  public:
+    // Constructor
+    Output(int ID);
+
+    // Pulse State
+    void Pulse(int PPQN, unsigned long tickCounter); // Timing stage, called from the clock ISR
+    void Render(int PPQN);                           // Render stage, called at the control rate
+    void GenEnvelope();
+    void SetAudioCapable(bool capable) { _audioCapable = capable; } // Output can stream the audio oscillator
+    bool IsAudioRunning() { return _waveformType == WaveformType::Oscillator; }
+    void FillAudioBlock(int PPQN, float ticksPerSample, uint16_t *samples, int count);
+
+    // Output State
+    void ToggleMasterState() { SetMasterState(!_masterState); }
+    void SetMasterState(bool state);
+
+    // Output Level
+    uint32_t GetLevel() { return _level; }
+    uint32_t GetOutputLevel(); // Output Level based on the waveform and pulse state
+    void QuantizerCVValue(float CVValue);
+    const char *GetLevelDescription(char *buffer) { return PercentDescription(buffer, _level); }
+    void SetLevel(int level) {
+        _level = constrain(level, 0, 100);
+        _levelScale = (_level << 12) / 100;
+    }
+
+    // Output Offset
+    int GetOffset() { return _offset; }
+    void SetOffset(int offset) {
+        _offset = constrain(offset, 0, 100);
+        _offsetLevel = (_offset * MaxDACValue + 50) / 100;
+    }
+    const char *GetOffsetDescription(char *buffer) { return PercentDescription(buffer, _offset); }
 
     // Waveform Type
     int GetWaveformTypeIndex() { return int(_waveformType); }
     void SetWaveformType(WaveformType type);
+    int GetWaveformTypeAmount() { return _audioCapable ? WaveformTypeLength : WaveformTypeLength - 1; }
     WaveformType GetWaveformType() { return _waveformType; }
-    String GetWaveformTypeDescription() { return WaveformTypeDescriptions[_waveformType]; }
+    const char *GetWaveformTypeDescription() { return WaveformTypeDescriptions[_waveformType]; }
 
     // Trigger mode control
     void SetTriggerMode(bool enabled) { _triggerMode = enabled; }
@@ -176,10 +400,11 @@ class Output {
     void SetExternalTrigger(bool state) {
         if (state != _externaltrigger) {
             _externaltrigger = state;
+            // Picked up by GenEnvelope() on the next control tick
             if (state)
-                HandleTrigger();
+                _triggerPending = true;
             else
-                HandleGateRelease();
+                _releasePending = true;
         }
     }
     void SetCVValue(float CVValue) { _inputCV = CVValue; }; // Set the input CV value for the quantizer
@@ -195,16 +420,14 @@ class Output {
     float GetDecay() { return _envParams.decay; }
     float GetSustain() { return _envParams.sustain; }
     float GetRelease() { return _envParams.release; }
-    String GetAttackDescription() {
-        return _envParams.attack > 999 ? String(_envParams.attack / 1000.0f, 1) + "s" : String(_envParams.attack) + "ms";
-    }
-    String GetDecayDescription() { return _envParams.decay > 999 ? String(_envParams.decay / 1000.0f, 1) + "s" : String(_envParams.decay) + "ms"; }
-    String GetSustainDescription() { return String(_envParams.sustain) + "%"; }
-    String GetReleaseDescription() { return _envParams.release > 999 ? String(_envParams.release / 1000.0f, 1) + "s" : String(_envParams.release) + "ms"; }
+    const char *GetAttackDescription(char *buffer) { return TimeDescription(buffer, _envParams.attack); }
+    const char *GetDecayDescription(char *buffer) { return TimeDescription(buffer, _envParams.decay); }
+    const char *GetSustainDescription(char *buffer) { return PercentDescription(buffer, int(_envParams.sustain + 0.5f)); }
+    const char *GetReleaseDescription(char *buffer) { return TimeDescription(buffer, _envParams.release); }
     void SetRetrigger(bool state) { _envParams.retrigger = state; }
     bool GetRetrigger() { return _envParams.retrigger; }
     void ToggleRetrigger() { _envParams.retrigger = !_envParams.retrigger; }
-    String GetRetriggerDescription() { return _envParams.retrigger ? "Yes" : "No"; }
+    const char *GetRetriggerDescription() { return _envParams.retrigger ? "Yes" : "No"; }
     void SetAttackCurve(float curve) { _envParams.attackCurve = constrain(curve, 0.0f, 1.0f); }
     void SetDecayCurve(float curve) { _envParams.decayCurve = constrain(curve, 0.0f, 1.0f); }
     void SetReleaseCurve(float curve) { _envParams.releaseCurve = constrain(curve, 0.0f, 1.0f); }
@@ -217,7 +440,7 @@ class Output {
         SetReleaseCurve(curve);
     }
     float GetCurve() { return (_envParams.attackCurve + _envParams.decayCurve + _envParams.releaseCurve) / 3.0f; }
-    String GetCurveDescription() { return String(GetCurve() * 100, 0) + "%"; }
+    const char *GetCurveDescription(char *buffer) { return PercentDescription(buffer, int(GetCurve() * 100 + 0.5f)); }
 
     // Quantizer
     QuantizerParams GetQuantizerParams() { return _quantizerParams; }
@@ -226,62 +449,48 @@ class Output {
     void SetQuantizerEnable(bool enable) { _quantizerParams.enable = enable; }
     bool GetQuantizerEnable() { return _quantizerParams.enable; }
     void ToggleQuantizer() { _quantizerParams.enable = !_quantizerParams.enable; }
-    String GetQuantizerEnableDescription() { return _quantizerParams.enable ? "On" : "Off"; }
+    const char *GetQuantizerEnableDescription() { return _quantizerParams.enable ? "On" : "Off"; }
     void SetQuantizerOctaveShift(int shift) {
         _quantizerParams.octaveShift = constrain(shift, 0, 6);
         SetupQuantizer();
     }
     int GetQuantizerOctaveShift() { return _quantizerParams.octaveShift; }
-    String GetQuantizerOctaveShiftDescription() { return String(_quantizerParams.octaveShift - 3); }
+    const char *GetQuantizerOctaveShiftDescription(char *buffer) {
+        snprintf(buffer, DESCRIPTION_LENGTH, "%d", _quantizerParams.octaveShift - 3);
+        return buffer;
+    }
     void SetQuantizerChannelSensitivity(int sensitivity) {
         _quantizerParams.channelSensitivity = constrain(sensitivity, 0, 8);
         SetupQuantizer();
     }
     int GetQuantizerChannelSensitivity() { return _quantizerParams.channelSensitivity; }
-    String GetQuantizerChannelSensitivityDescription() { return String(_quantizerParams.channelSensitivity); }
+    const char *GetQuantizerChannelSensitivityDescription(char *buffer) {
+        snprintf(buffer, DESCRIPTION_LENGTH, "%d", _quantizerParams.channelSensitivity);
+        return buffer;
+    }
     void SetQuantizerScaleIndex(int index) {
         _quantizerParams.scaleIndex = constrain(index, 0, numScales);
         SetupQuantizer();
     }
     int GetQuantizerScaleIndex() { return _quantizerParams.scaleIndex; }
-    String GetQuantizerScaleDescription() { return scaleNames[_quantizerParams.scaleIndex]; }
+    const char *GetQuantizerScaleDescription() { return scaleNames[_quantizerParams.scaleIndex]; }
     void SetQuantizerNoteIndex(int index) {
         _quantizerParams.noteIndex = constrain(index, 0, 11);
         SetupQuantizer();
     }
     int GetQuantizerNoteIndex() { return _quantizerParams.noteIndex; }
-    String GetQuantizerNoteDescription() { return noteNames[_quantizerParams.noteIndex]; }
+    const char *GetQuantizerNoteDescription() { return noteNames[_quantizerParams.noteIndex]; }
 
   private:
     // Constants
-    const int MaxDACValue = 4095;
-    const float MaxWaveValue = 255.0;
-    static int const _dividerAmount = 19;
-    float _clockDividers[_dividerAmount] = {0.0078125, 0.015625, 0.03125, 0.0625, 0.125, 0.25, 0.3333333333, 0.5, 0.6666666667, 1.0, 1.5, 2.0, 3.0, 4.0, 8.0, 16.0, 24.0, 32.0, 10000};
-    String _dividerDescription[_dividerAmount] = {"/128", "/64", "/32", "/16", "/8", "/4", "/3", "/2", "/1.5", "x1", "x1.5", "x2", "x3", "x4", "x8", "x16", "x24", "x32", "Env"};
-    static int const MaxEuclideanSteps = 64;
-
-    // The shuffle of the TR-909 delays each even-numbered 1/16th by 2/96 of a beat for shuffle setting 1,
-    // 4/96 for 2, 6/96 for 3, 8/96 for 4, 10/96 for 5 and 12/96 for 6.
-    static int const _swingAmount = 7;
-    float _swingAmounts[_swingAmount] = {0, 2, 4, 6, 8, 10, 12};
-    String _swingAmountDescriptions[_swingAmount] = {"0", "2/96", "4/96", "6/96", "8/96", "10/96", "12/96"};
+    static int const MaxDACValue = 4095;
+    static constexpr float MaxWaveValue = 255.0f;
 
     // Variables
-    int _ID;
-    bool _externalClock = false;  // External clock state
-    OutputType _outputType;       // 0 = Digital, 1 = DAC
-    int _dividerIndex = 9;        // Default to 1
-    int _dutyCycle = 50;          // Default to 50%
-    int _phase = 0;               // Phase offset, default to 0% (in phase with master)
-    int _level = 100;             // Output voltage level for DAC outs (Default to 100%)
-    int _offset = 0;              // Output voltage offset for DAC outs (default to 0%)
-    bool _isPulseOn = false;      // Pulse state
-    bool _lastPulseState = false; // Last pulse state
-    bool _state = true;           // Output state
-    bool _oldState = true;        // Previous output state (for master stop)
-    bool _masterState = true;     // Master output state
-    int _pulseProbability = 100;  // % chance of pulse
+    int _level = 100;              // Output voltage level (Default to 100%)
+    int _offset = 0;               // Output voltage offset (default to 0%)
+    int32_t _levelScale = 1 << 12; // Level as a Q12 multiplier, 4096 is 100%
+    int32_t _offsetLevel = 0;      // Offset in DAC steps
 
     QuantizerParams _quantizerParams = {
         .enable = false,
@@ -295,42 +504,44 @@ class Output {
     float _inputCV = 0.0f;           // Input CV value for quantizer
     float _oldInputCV;
 
-    unsigned long _internalPulseCounter = 0; // Pulse counter (used for external clock division)
-    unsigned long _resetPulseStart = 0;      // Reset pulse start time
+    unsigned long _resetPulseStart = 0; // Reset pulse start time
 
     // Waveform generation variables
     WaveformType _waveformType = WaveformType::Square; // Default to square wave
     bool _waveActive = false;
-    bool _waveDirection = true; // Waveform direction (true = up, false = down)
     float _waveValue = 0.0f;
     uint32_t _oldOutputLevel = 0.0f;
-    float _triangleWaveStep = 0.0f;
-    float _sineWaveAngle = 0.0f;
-    unsigned long _inactiveTickCounter = 0;
     unsigned long _randomTickCounter = 0;
-    unsigned long _envTickCounter = 0; // Logarithmic envelope ticks
-
-    // Swing variables
-    int _swingEveryAmount = 16;         // Max swing every value
-    int _swingEvery = 2;                // Swing every x notes
-    unsigned int _swingAmountIndex = 0; // Swing amount index
-
-    // Euclidean rhythm variables
-    int _euclideanStepIndex = 0; // Current step in the pattern
-    EuclideanParams _euclideanParams = {
-        .enabled = false,
-        .steps = 10,   // Number of steps in the pattern
-        .triggers = 6, // Number of triggers in the pattern
-        .rotation = 1, // Rotation of the pattern
-        .pad = 0,      // No trigger steps added to the end of the pattern
-    };
-    int _euclideanRhythm[MaxEuclideanSteps]; // Euclidean rhythm pattern
+    uint8_t _noiseStep = 0;                    // Noise step of the last render
+    float _smoothNoiseWalk = MaxWaveValue / 2; // Random walk behind the smooth noise
+    float _smoothNoiseValue = 50.0f;           // Smoothed value
+    volatile uint32_t _waveformStartPhase = 0; // Pulse start as seen by the render stage
+
+    // The noise waveforms take this many new values per output period, so they follow the tempo and the divider
+    static int const NoiseStepBits = 7;
+    static int const NoiseSteps = 1 << NoiseStepBits;
+
+    // Waveform generators, indexed by WaveformType. Each one is evaluated at the phase since the pulse start,
+    // the ones that do not depend on it leave the parameter unnamed.
+    typedef void (Output::*WaveformGenerator)(uint32_t phase);
+    static const WaveformGenerator _waveformGenerators[];
+
+    // Audio rate oscillator
+    static int const AudioOctaves = 8; // Oscillator pitch above the output's own clock rate
+    bool _audioCapable = false;
+    uint32_t _audioPhase = 0;
+
+    // Edges queued by the clock ISR for the render stage (single producer, single consumer)
+    static uint8_t const TickQueueSize = 16;
+    volatile uint8_t _tickQueue[TickQueueSize];
+    volatile uint8_t _tickQueueHead = 0;
+    volatile uint8_t _tickQueueTail = 0;
 
     // Envelope
     bool _triggerMode = false;
     bool _externaltrigger = false;
-    unsigned long _envStartTime = 0;
-    float _lastEnvValue = 0.0f; // Stores last envelope value for retriggering
+    volatile bool _triggerPending = false; // Gate rose since the last control tick
+    volatile bool _releasePending = false; // Gate fell since the last control tick
 
     // ADSR envelope parameters
     EnvelopeParams _envParams = {
@@ -354,8 +565,54 @@ class Output {
         Release
     } _envState = Idle;
 
+    // Current stage, the level follows level = coefficient * level + offset on every control tick
+    float _envCoefficient = 1.0f;
+    float _envOffset = 0.0f;
+    float _envTarget = 0.0f;         // Level at the end of the stage
+    unsigned long _envTicksLeft = 0; // Control ticks until the end of the stage
+
     // -------------- Private Functions --------------
 
+    // Queue an edge for the render stage, dropping it if the renderer has fallen behind
+    void QueueTickEvent(TickEvent event) {
+        uint8_t next = (_tickQueueHead + 1) % TickQueueSize;
+        if (next != _tickQueueTail) {
+            _tickQueue[_tickQueueHead] = event;
+            _tickQueueHead = next;
+        }
+    }
+
+    // Apply an edge to the waveform state
+    void ApplyTickEvent(TickEvent event) {
+        switch (event) {
+        case TickEvent::TickStart:
+            StartWaveform();
+            break;
+        case TickEvent::TickSkip:
+            // We stop the waveform directly if the pulse probability is not met since StopWaveform() is used for the square wave
+            ResetWaveform();
+            break;
+        case TickEvent::TickStop:
+            StopWaveform();
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Phase within the current period, counted from the pulse start
+    uint32_t WaveformPhase() {
+        uint32_t start, phase;
+        do {
+            start = _waveformStartPhase;
+            phase = _phaseAccumulator;
+        } while (start != _waveformStartPhase);
+        return phase - start;
+    }
+
+    // Fraction of the period a phase stands for, 0 to 1
+    static float PhasePosition(uint32_t phase) { return phase * (1.0f / 4294967296.0f); }
+
     // Start the waveform generation
     void StartWaveform() {
         _waveActive = true;
@@ -367,26 +624,21 @@ class Output {
         case WaveformType::Sawtooth:
         case WaveformType::Sine:
         case WaveformType::Parabolic:
-            if (!_externalClock) {
-                _waveValue = 0.0f;
-                _triangleWaveStep = 0.0f;
-                _sineWaveAngle = 0.0f;
-            }
+            // The waveform phase restarts from the pulse start
             break;
         case WaveformType::ExpEnvelope:
         case WaveformType::LogEnvelope:
             _waveValue = 0; // Start at 0 value for envelopes
-            _envTickCounter = 0;
             break;
         case WaveformType::InvExpEnvelope:
         case WaveformType::InvLogEnvelope:
             _waveValue = MaxWaveValue; // Start at maximum value for inverted envelopes
-            _envTickCounter = 0;
             break;
         case WaveformType::Noise:
         case WaveformType::SmoothNoise:
         case WaveformType::SampleHold:
             _randomTickCounter = 0;
+            _noiseStep = 0;
             break;
         case WaveformType::ResetTrig:
             _isPulseOn = (_waveValue > 0);
@@ -399,9 +651,7 @@ class Output {
         case WaveformType::AREnvelope:
         case WaveformType::ADSREnvelope:
             if (_envState == EnvelopeState::Idle || _envParams.retrigger) {
-                _lastEnvValue = _waveValue;
-                _envState = EnvelopeState::Attack;
-                _envStartTime = micros();
+                EnterEnvelopeStage(EnvelopeState::Attack);
                 _waveActive = true;
             }
             break;
@@ -416,15 +666,22 @@ class Output {
         switch (_waveformType) {
         case WaveformType::ExpEnvelope:
         case WaveformType::LogEnvelope:
+            // Envelopes run to the end of their duty cycle, which is always over by the next period
+            if (_waveActive) {
+                _waveValue = MaxWaveValue;
+                _waveActive = false;
+            }
+            break;
         case WaveformType::InvExpEnvelope:
         case WaveformType::InvLogEnvelope:
+            if (_waveActive) {
+                _waveValue = 0.0f;
+                _waveActive = false;
+            }
             break;
         default:
             _waveActive = false;
-            _waveDirection = true;
             _waveValue = 0.0f;
-            _triangleWaveStep = 0.0f;
-            _sineWaveAngle = 0.0f;
         }
     }
 
@@ -462,273 +719,247 @@ class Output {
         }
     }
 
-    // Generate a triangle wave
-    void GenerateTriangleWave(int PPQN) {
-        if (_waveActive) {
-            float periodTicks = PPQN / _clockDividers[_dividerIndex];
-            float risingTicks = periodTicks * (_dutyCycle / 100.0f);
-            float fallingTicks = periodTicks - risingTicks;
-
-            // Calculate step sizes
-            float risingStep = MaxWaveValue / risingTicks;
-            float fallingStep = MaxWaveValue / fallingTicks;
+    // Waveforms driven by their edges, the envelope generator or the audio stream keep their value
+    void HoldWaveform(uint32_t) {}
 
-            // Update waveform value
-            if (_waveDirection) {
-                _waveValue += risingStep;
-                if (_waveValue >= MaxWaveValue) {
-                    _waveValue = MaxWaveValue;
-                    _waveDirection = false;
-                }
+    // Generate a triangle wave, rising over the duty cycle and falling over the rest of the period
+    void GenerateTriangleWave(uint32_t phase) {
+        if (_waveActive) {
+            float position = PhasePosition(phase);
+            float duty = _dutyCycle / 100.0f;
+            if (position < duty) {
+                _waveValue = MaxWaveValue * position / duty;
             } else {
-                _waveValue -= fallingStep;
-                if (_waveValue <= 0.0f) {
-                    _waveValue = 0.0f;
-                    _waveDirection = true;
-                }
+                _waveValue = MaxWaveValue * (1.0f - position) / (1.0f - duty);
             }
             _isPulseOn = true;
         }
     }
 
-    // Generate a sine wave
-    void GenerateSineWave(int PPQN) {
+    // Generate a sine wave, rising over the duty cycle and falling over the rest of the period
+    void GenerateSineWave(uint32_t phase) {
         if (_waveActive) {
-            // Calculate the period of the waveform in ticks
-            float periodInTicks = PPQN / _clockDividers[_dividerIndex];
-
-            // Calculate the angle increment per tick
-            float angleIncrement = (2.0f * PI) / periodInTicks;
-
-            // Update the angle for the sine function
-            _sineWaveAngle += angleIncrement;
-
-            // Keep the angle within 0 to 2*PI
-            if (_sineWaveAngle >= 2.0f * PI) {
-                _sineWaveAngle -= 2.0f * PI;
-            }
-
-            // Apply phase shift to align the lowest point with pulse start
-            float shiftedAngle = _sineWaveAngle + (3.0f * PI / 2.0f);
-
-            // Calculate the sine value scaled to the amplitude range
-            // Adjust the sine value based on the duty cycle
-            float sineValue = sin(shiftedAngle);
-            if (sineValue > 0) {
-                sineValue = pow(sineValue, _dutyCycle / 50.0f);
+            // Warp the phase so the rising half turn spans the duty cycle, 50% leaves it untouched
+            uint32_t duty = _schedules[_activeSchedule].dutyPhase;
+            uint32_t warped;
+            if (phase < duty) {
+                warped = (uint64_t(phase) << 31) / duty;
             } else {
-                sineValue = -pow(-sineValue, _dutyCycle / 50.0f);
+                warped = 0x80000000u + uint32_t((uint64_t(phase - duty) << 31) / ((uint64_t(1) << 32) - duty));
             }
-            _waveValue = (sineValue * MaxWaveValue / 2) + MaxWaveValue / 2;
+
+            // Apply a 3/4 turn phase shift to align the lowest point with pulse start
+            _waveValue = (SineQ15(warped + 0xC0000000) + 32767) * (MaxWaveValue / 65534.0f);
 
             _isPulseOn = true;
         }
     }
 
-    // Generate a parabolic wave
-    void GenerateParabolicWave(int PPQN) {
+    // Generate a parabolic wave, a half sine over the duty cycle
+    void GenerateParabolicWave(uint32_t phase) {
         if (_waveActive) {
-            float periodInTicks = PPQN / _clockDividers[_dividerIndex];
-            float activeTicks = periodInTicks * (_dutyCycle / 100.0f);
-            float angleIncrement = (PI) / activeTicks; // Half sine wave for duty cycle
-
-            _sineWaveAngle += angleIncrement;
-            if (_sineWaveAngle >= PI) {
-                _sineWaveAngle = 0.0f;
-                // Inactive period
+            float position = PhasePosition(phase);
+            float duty = _dutyCycle / 100.0f;
+            if (position >= duty) {
+                // Inactive for the rest of the period
+                _waveValue = 0.0f;
                 _waveActive = false;
-                _isPulseOn = false;
-                _inactiveTickCounter = periodInTicks - activeTicks;
+                return;
             }
-
-            // Calculate sine value
-            _waveValue = sin(_sineWaveAngle) * MaxWaveValue;
+            // Half a sine turn over the duty cycle
+            uint32_t halfTurnPhase = position / duty * 2147483648.0f;
+            _waveValue = SineQ15(halfTurnPhase) * MaxWaveValue / 32767.0f;
             _isPulseOn = true;
         }
     }
 
-    // Generate a sawtooth wave
-    void GenerateSawtoothWave(int PPQN) {
+    // Generate a sawtooth wave, ramping up over the duty cycle
+    void GenerateSawtoothWave(uint32_t phase) {
         if (_waveActive) {
-            float periodTicks = PPQN / _clockDividers[_dividerIndex];
-            float activeTicks = periodTicks * (_dutyCycle / 100.0f);
-            float inactiveTicks = periodTicks - activeTicks;
-
-            // Calculate step size
-            float step = MaxWaveValue / activeTicks;
-
-            // Update waveform value
-            _waveValue += step;
-            if (_waveValue >= MaxWaveValue) {
+            float position = PhasePosition(phase);
+            float duty = _dutyCycle / 100.0f;
+            if (position >= duty) {
+                // Inactive for the rest of the period
                 _waveValue = 0.0f;
-                // Adjust for inactive period
                 _waveActive = false;
-                _inactiveTickCounter = inactiveTicks;
+                _isPulseOn = false;
+                return;
             }
+            _waveValue = MaxWaveValue * position / duty;
             _isPulseOn = true;
         } else {
-            // Handle inactive period
-            _inactiveTickCounter--;
-            if (_inactiveTickCounter <= 0) {
-                _waveActive = true;
-            }
             _isPulseOn = false;
         }
     }
 
+    // Noise steps the phase went through since the last render, and one at the pulse start
+    int NoiseStepsCrossed(uint32_t phase) {
+        uint8_t step = phase >> (32 - NoiseStepBits);
+        int crossed = uint8_t(step - _noiseStep) & (NoiseSteps - 1);
+        _noiseStep = step;
+        if (_randomTickCounter++ == 0) {
+            crossed = max(crossed, 1);
+        }
+        return crossed;
+    }
+
     // Generate random values
-    void GenerateNoiseWave(int PPQN) {
+    void GenerateNoiseWave(uint32_t phase) {
         if (_waveActive) {
-            // Generate white noise waveform
-            _waveValue = random(MaxWaveValue + 1); // Random value
+            // Generate white noise waveform, a new random value on every noise step
+            if (NoiseStepsCrossed(phase) > 0) {
+                _waveValue = _random.Below(MaxWaveValue + 1);
+            }
             _isPulseOn = true;
-            _randomTickCounter++;
         }
     }
 
     // Generate smooth random waveform
-    void GenerateSmoothNoiseWave(int PPQN) {
+    void GenerateSmoothNoiseWave(uint32_t phase) {
         if (_waveActive) {
             // Generate smooth random waveform with smooth peaks and valleys
-            static float phase = 0.0f;
-            static float frequency = 0.3f;             // Adjust frequency for smoothness
-            static float amplitude = MaxWaveValue / 2; // Amplitude for wave value range
-            static float lastValue = MaxWaveValue / 2; // Last generated value
-            static float smoothValue = 50.0f;          // Smoothed value
-
-            // Increment phase
-            phase += frequency;
-
-            // Generate smooth random value using a random walk
-            float randomStep = (static_cast<float>(rand()) / RAND_MAX - 0.5f) * 2.0f; // Random step between -1 and 1
-            lastValue += randomStep * amplitude * frequency;                          // Adjust step size by amplitude and frequency
-            lastValue = fmin(fmax(lastValue, 0.0f), MaxWaveValue);                    // Clamp value
-
-            // Apply a low-pass filter to smooth out the waveform
-            float alpha = 0.01f; // Smoothing factor (0 < alpha < 1)
-            smoothValue = alpha * lastValue + (1.0f - alpha) * smoothValue;
+            const float frequency = 0.3f;             // Adjust frequency for smoothness
+            const float amplitude = MaxWaveValue / 2; // Amplitude for wave value range
+
+            // One step of the walk and the filter for every noise step, so the speed follows the clock
+            for (int steps = NoiseStepsCrossed(phase); steps > 0; steps--) {
+                // Generate smooth random value using a random walk
+                float randomStep = _random.NextQ15() * (1.0f / 32768.0f);             // Random step between -1 and 1
+                _smoothNoiseWalk += randomStep * amplitude * frequency;              // Adjust step size by amplitude and frequency
+                _smoothNoiseWalk = fmin(fmax(_smoothNoiseWalk, 0.0f), MaxWaveValue); // Clamp value
+
+                // Apply a low-pass filter to smooth out the waveform
+                float alpha = 0.01f; // Smoothing factor (0 < alpha < 1)
+                _smoothNoiseValue = alpha * _smoothNoiseWalk + (1.0f - alpha) * _smoothNoiseValue;
+            }
 
-            _waveValue = smoothValue;
+            _waveValue = _smoothNoiseValue;
 
             _isPulseOn = true;
         }
     }
 
     // Generate an inverted exponential envelope waveform (starts from 100% and decays to 0%)
-    void GenerateInvExpEnvelope(int PPQN) {
+    void GenerateInvExpEnvelope(uint32_t phase) {
         if (_waveActive) {
-            float periodTicks = PPQN / _clockDividers[_dividerIndex];
-            float decayTicks = periodTicks * (_dutyCycle / 100.0f);
-
-            if (_envTickCounter >= decayTicks) {
+            float position = PhasePosition(phase);
+            float duty = _dutyCycle / 100.0f;
+            if (position >= duty) {
                 _waveValue = 0.0f;
                 _waveActive = false;
-                _envTickCounter = 0; // Reset for the next pulse
                 return;
             }
 
-            // Calculate decay factor for the exponential decay
-            float k = 6.90776f / decayTicks; // ln(100) ≈ 4.60517, total decay over decayTicks
-            _waveValue = MaxWaveValue * exp(-k * _envTickCounter);
-
-            _envTickCounter++;
+            // Exponential decay over the duty cycle
+            _waveValue = LookupQ15(expDecayTable.values, CurveTableBits, FractionToPosition(position / duty)) * MaxWaveValue / 32767.0f;
             _isPulseOn = true;
         }
     }
 
     // Generate an inverted logarithm envelope waveform (starts from 100% and decays to 0%)
-    void GenerateInvLogEnvelope(int PPQN) {
+    void GenerateInvLogEnvelope(uint32_t phase) {
         if (_waveActive) {
-            float periodTicks = PPQN / _clockDividers[_dividerIndex];
-            float decayTicks = periodTicks * (_dutyCycle / 100.0f);
-
-            if (_envTickCounter >= decayTicks) {
+            float position = PhasePosition(phase);
+            float duty = _dutyCycle / 100.0f;
+            if (position >= duty) {
                 _waveValue = 0.0f;
                 _waveActive = false;
-                _envTickCounter = 0; // Reset for the next pulse
                 return;
             }
 
-            // Calculate decay factor to span the entire pulse duration
-            float decayFactor = log10(decayTicks - _envTickCounter + 1) / log10(decayTicks + 1);
+            // Calculate decay factor to span the entire pulse duration, log(n + 1) / log(decayTicks + 1)
+            float decayTicks = PeriodTicks() * duty;
+            float envTicks = decayTicks * position / duty;
+            int32_t fullScale = Log2Q16(uint32_t((decayTicks + 1) * 65536.0f));
+            float decayFactor = fullScale > 0 ? float(Log2Q16(uint32_t((decayTicks - envTicks + 1) * 65536.0f))) / fullScale : 0.0f;
 
             // Update waveform value
             _waveValue = decayFactor * MaxWaveValue; // Scale to 0-100%
-
-            _envTickCounter++;
             _isPulseOn = true;
         }
     }
 
     // Generate an exponential envelope waveform (starts from 0% and rises to 100%)
-    void GenerateExpEnvelope(int PPQN) {
+    void GenerateExpEnvelope(uint32_t phase) {
         if (_waveActive) {
-            float periodTicks = PPQN / _clockDividers[_dividerIndex];
-            float attackTicks = periodTicks * (_dutyCycle / 100.0f);
-
-            if (_envTickCounter >= attackTicks) {
+            float position = PhasePosition(phase);
+            float duty = _dutyCycle / 100.0f;
+            if (position >= duty) {
                 _waveValue = MaxWaveValue;
                 _waveActive = false;
-                _envTickCounter = 0; // Reset for the next pulse
                 return;
             }
 
             // Use normalized time from 0-1
-            float normalizedTime = _envTickCounter / attackTicks;
+            float normalizedTime = position / duty;
 
-            // Apply exponential curve: e^(k*t) - 1 / (e^k - 1)
+            // Apply exponential curve: e^(k*t) - 1 / (e^k - 1) with k = 4
             // This gives a true exponential curve that starts at 0 and ends at 1
-            float k = 4.0f; // Determines curve steepness
-            _waveValue = MaxWaveValue * ((exp(k * normalizedTime) - 1.0f) / (exp(k) - 1.0f));
-
-            _envTickCounter++;
+            _waveValue = LookupQ15(expRiseTable.values, CurveTableBits, FractionToPosition(normalizedTime)) * MaxWaveValue / 32767.0f;
             _isPulseOn = true;
         }
     }
 
     // Generate a logarithmic envelope waveform (starts from 0% and rises to 100%)
-    void GenerateLogEnvelope(int PPQN) {
+    void GenerateLogEnvelope(uint32_t phase) {
         if (_waveActive) {
-            float periodTicks = PPQN / _clockDividers[_dividerIndex];
-            float attackTicks = periodTicks * (_dutyCycle / 100.0f);
-
-            if (_envTickCounter >= attackTicks) {
+            float position = PhasePosition(phase);
+            float duty = _dutyCycle / 100.0f;
+            if (position >= duty) {
                 _waveValue = MaxWaveValue;
                 _waveActive = false;
-                _envTickCounter = 0; // Reset for the next pulse
                 return;
             }
 
-            // Calculate attack factor to span the entire pulse duration
-            float attackFactor = log10(_envTickCounter + 1) / log10(attackTicks + 1);
+            // Calculate attack factor to span the entire pulse duration, log(n + 1) / log(attackTicks + 1)
+            float attackTicks = PeriodTicks() * duty;
+            float envTicks = attackTicks * position / duty;
+            int32_t fullScale = Log2Q16(uint32_t((attackTicks + 1) * 65536.0f));
+            float attackFactor = fullScale > 0 ? float(Log2Q16(uint32_t((envTicks + 1) * 65536.0f))) / fullScale : 1.0f;
 
             // Update waveform value
             _waveValue = attackFactor * MaxWaveValue; // Scale to 0-100%
-
-            _envTickCounter++;
             _isPulseOn = true;
         }
     }
 
     // Generate a Sample and Hold waveform where on each pulse, a random value is generated
-    void GenerateSampleHold(int PPQN) {
+    void GenerateSampleHold(uint32_t) {
         if (_waveActive) {
             // Generate a random value at the start of each pulse
             if (_randomTickCounter == 0) {
-                _waveValue = random(MaxWaveValue + 1);
+                _waveValue = _random.Below(MaxWaveValue + 1);
             }
             _isPulseOn = true;
             _randomTickCounter++;
         }
     }
 
+    // Full level while the clock runs
+    void GeneratePlay(uint32_t) {
+        if (_waveActive) {
+            _waveValue = MaxWaveValue;
+            _isPulseOn = true;
+        } else {
+            _waveValue = 0;
+            _isPulseOn = false;
+        }
+    }
+
+    // Follow the CV input, the quantizer is applied on the way out
+    void GenerateQuantizeInput(uint32_t) {
+        _waveValue = (_inputCV / MaxDACValue) * MaxWaveValue;
+        _isPulseOn = true;
+    }
+
     // ----------- Envelope Generation Functions -----------
     void HandleTrigger() {
         if (_triggerMode && (_waveformType == WaveformType::ADEnvelope || _waveformType == WaveformType::AREnvelope || _waveformType == WaveformType::ADSREnvelope)) {
             if (!_waveActive || _envParams.retrigger) {
-                _lastEnvValue = _envParams.retrigger ? _waveValue : 0.0f;
-                _envState = EnvelopeState::Attack;
-                _envStartTime = micros();
+                if (!_envParams.retrigger) {
+                    _waveValue = 0.0f;
+                }
+                EnterEnvelopeStage(EnvelopeState::Attack);
                 _waveActive = true;
                 _isPulseOn = true;
             }
@@ -740,202 +971,384 @@ class Output {
             if (_waveformType == WaveformType::AREnvelope ||
                 _waveformType == WaveformType::ADSREnvelope) {
                 if (_waveActive && _envState != EnvelopeState::Release) {
-                    _lastEnvValue = _waveValue;
-                    _envState = EnvelopeState::Release;
-                    _envStartTime = micros();
+                    EnterEnvelopeStage(EnvelopeState::Release);
                 }
             }
         }
     }
 
-    float ApplyCurve(float input, float curve) {
-        // input and output are 0-1 range
-        if (curve == 0.5f)
-            return input; // Linear
-
-        // Convert curve 0-1 to power range 0.1 to 10
-        float power = pow(10.0f, (curve - 0.5f) * 2.0f);
-        return pow(input, power);
-    }
-
-    // Generate an Attack-Decay envelope waveform
-    void GenerateADEnvelope() {
-        if (!_waveActive)
+    // Work out the coefficients of a stage once when entering it, so every control tick after that
+    // is a single multiply-add. The stage starts from the current level.
+    void EnterEnvelopeStage(EnvelopeState state) {
+        float stageTime, curve;
+        _envState = state;
+        switch (state) {
+        case EnvelopeState::Attack:
+            _envTarget = MaxWaveValue;
+            stageTime = _envParams.attack;
+            curve = _envParams.attackCurve;
+            break;
+        case EnvelopeState::Decay:
+            _envTarget = _waveformType == WaveformType::ADSREnvelope ? MaxWaveValue * (_envParams.sustain / 100.0f) : 0.0f;
+            stageTime = _envParams.decay;
+            curve = _envParams.decayCurve;
+            break;
+        case EnvelopeState::Release:
+            _envTarget = 0.0f;
+            stageTime = _envParams.release;
+            curve = _envParams.releaseCurve;
+            break;
+        default:
+            // Holding stages keep their level
+            _envTicksLeft = 0;
             return;
+        }
+        _envTicksLeft = max(1UL, (unsigned long)(stageTime * CONTROL_RATE / 1000.0f));
+
+        // The stage follows (e^(k*t) - 1) / (e^k - 1) from the start to the target level. Curve 0-1 maps
+        // to k = -8..8, where 0.5 is linear and higher values start slowly and end steeply.
+        float k = (curve - 0.5f) * 16.0f;
+        float change = _envTarget - _waveValue;
+        if (fabs(k) < 0.01f) {
+            _envCoefficient = 1.0f;
+            _envOffset = change / _envTicksLeft;
+        } else {
+            _envCoefficient = exp(k / _envTicksLeft);
+            _envOffset = (1.0f - _envCoefficient) * _waveValue + change * (_envCoefficient - 1.0f) / (exp(k) - 1.0f);
+        }
+    }
 
-        float currentTime = (micros() - _envStartTime) / 1000.0f;
-
+    // Move on once a stage has run its course
+    void NextEnvelopeStage() {
         switch (_envState) {
-        case EnvelopeState::Attack: {
-            float normalizedTime = currentTime / _envParams.attack;
-            float curvedTime = ApplyCurve(normalizedTime, _envParams.attackCurve);
-
-            if (_envParams.retrigger) {
-                _waveValue = _lastEnvValue + ((MaxWaveValue - _lastEnvValue) * curvedTime);
+        case EnvelopeState::Attack:
+            EnterEnvelopeStage(_waveformType == WaveformType::AREnvelope ? EnvelopeState::AttackHold : EnvelopeState::Decay);
+            break;
+        case EnvelopeState::Decay:
+            if (_waveformType == WaveformType::ADSREnvelope) {
+                EnterEnvelopeStage(EnvelopeState::Sustain);
             } else {
-                _waveValue = curvedTime * MaxWaveValue;
-            }
-
-            if (currentTime >= _envParams.attack) {
-                _envState = EnvelopeState::Decay;
-                _envStartTime = micros();
-                _lastEnvValue = _waveValue;
-            }
-        } break;
-
-        case EnvelopeState::Decay: {
-            float normalizedTime = currentTime / _envParams.decay;
-            float curvedTime = ApplyCurve(normalizedTime, _envParams.decayCurve);
-            _waveValue = MaxWaveValue * (1.0f - curvedTime);
-
-            if (currentTime >= _envParams.decay) {
+                // The AD envelope ends after its decay
                 _waveActive = false;
                 _envState = EnvelopeState::Idle;
-                _lastEnvValue = 0;
             }
-        } break;
-
+            break;
+        case EnvelopeState::Release:
+            _waveActive = false;
+            _envState = EnvelopeState::Idle;
+            break;
         default:
             break;
         }
-
-        _waveValue = constrain(_waveValue, 0, MaxWaveValue);
     }
 
-    // Generate an Attack-Release envelope waveform
-    void GenerateAREnvelope() {
+    // Advance the envelope by one control tick
+    void AdvanceEnvelope() {
         if (!_waveActive)
             return;
 
-        float currentTime = (micros() - _envStartTime) / 1000.0f;
-
         switch (_envState) {
-        case EnvelopeState::Attack: {
-            float normalizedTime = currentTime / _envParams.attack;
-            float curvedTime = ApplyCurve(normalizedTime, _envParams.attackCurve);
-
-            if (_envParams.retrigger) {
-                _waveValue = _lastEnvValue + ((MaxWaveValue - _lastEnvValue) * curvedTime);
-            } else {
-                _waveValue = curvedTime * MaxWaveValue;
-            }
-
-            if (currentTime >= _envParams.attack) {
-                _envState = EnvelopeState::AttackHold;
-                _waveValue = MaxWaveValue;
-                _lastEnvValue = _waveValue;
-            }
-        } break;
-
         case EnvelopeState::AttackHold:
             _waveValue = MaxWaveValue;
             break;
-
-        case EnvelopeState::Release: {
-            float normalizedTime = currentTime / _envParams.release;
-            float curvedTime = ApplyCurve(normalizedTime, _envParams.releaseCurve);
-            _waveValue = _lastEnvValue * (1.0f - curvedTime);
-
-            if (currentTime >= _envParams.release) {
-                _waveActive = false;
-                _envState = EnvelopeState::Idle;
-                _lastEnvValue = 0;
-            }
-        } break;
-
+        case EnvelopeState::Sustain:
+            _waveValue = MaxWaveValue * (_envParams.sustain / 100.0f);
+            break;
         default:
+            if (_envTicksLeft > 0) {
+                _waveValue = _envCoefficient * _waveValue + _envOffset;
+                if (--_envTicksLeft == 0) {
+                    _waveValue = _envTarget;
+                    NextEnvelopeStage();
+                }
+            }
             break;
         }
         _waveValue = constrain(_waveValue, 0, MaxWaveValue);
     }
+};
 
-    // Generate an ADSR envelope waveform
-    void GenerateADSREnvelope() {
-        if (!_waveActive)
-            return;
+typedef Output<OutputType::DigitalOut> GateOutput;
+typedef Output<OutputType::DACOut> DACOutput;
+
+// In the order of WaveformType
+const DACOutput::WaveformGenerator DACOutput::_waveformGenerators[] = {
+    &DACOutput::HoldWaveform,            // Square
+    &DACOutput::GenerateTriangleWave,    // Triangle
+    &DACOutput::GenerateSineWave,        // Sine
+    &DACOutput::GenerateParabolicWave,   // Parabolic
+    &DACOutput::GenerateSawtoothWave,    // Sawtooth
+    &DACOutput::GenerateExpEnvelope,     // ExpEnvelope
+    &DACOutput::GenerateLogEnvelope,     // LogEnvelope
+    &DACOutput::GenerateInvExpEnvelope,  // InvExpEnvelope
+    &DACOutput::GenerateInvLogEnvelope,  // InvLogEnvelope
+    &DACOutput::GenerateNoiseWave,       // Noise
+    &DACOutput::GenerateSmoothNoiseWave, // SmoothNoise
+    &DACOutput::GenerateSampleHold,      // SampleHold
+    &DACOutput::HoldWaveform,            // ResetTrig
+    &DACOutput::GeneratePlay,            // Play
+    &DACOutput::HoldWaveform,            // ADEnvelope
+    &DACOutput::HoldWaveform,            // AREnvelope
+    &DACOutput::HoldWaveform,            // ADSREnvelope
+    &DACOutput::GenerateQuantizeInput,   // QuantizeInput
+    &DACOutput::HoldWaveform,            // Oscillator
+};
 
-        float currentTime = (micros() - _envStartTime) / 1000.0f;
+// ---------------- Timing Core ----------------
 
-        switch (_envState) {
-        case EnvelopeState::Attack: {
-            float normalizedTime = currentTime / _envParams.attack;
-            float curvedTime = ApplyCurve(normalizedTime, _envParams.attackCurve);
+// Constructor
+OutputCore::OutputCore(int ID, int lastDivider) {
+    _ID = ID;
+    _lastDivider = lastDivider;
+    _euclideanRhythm = GeneratePattern(_euclideanParams);
+    SetRandomSeed(0);
+}
 
-            if (_envParams.retrigger) {
-                _waveValue = _lastEnvValue + ((MaxWaveValue - _lastEnvValue) * curvedTime);
-            } else {
-                _waveValue = curvedTime * MaxWaveValue;
-            }
+// Decide if the pulse on this edge is triggered based on probability and the Euclidean rhythm
+TickEvent OutputCore::GeneratePulse() {
+    bool shouldTrigger = (int(_random.Below(100)) < _pulseProbability);
+    if (!_euclideanParams.enabled) {
+        // If not using Euclidean rhythm, generate waveform based on the pulse probability
+        return shouldTrigger ? TickEvent::TickStart : TickEvent::TickSkip;
+    }
 
-            if (currentTime >= _envParams.attack) {
-                _envState = EnvelopeState::Decay;
-                _envStartTime = micros();
-                _lastEnvValue = _waveValue;
-            }
-        } break;
+    // If using Euclidean rhythm, check if the current step is active
+    bool activeStep = PatternStep(_euclideanRhythm, _euclideanStepIndex);
+    _euclideanStepIndex++;
+    // Restart the Euclidean rhythm if it reaches the end
+    if (_euclideanStepIndex >= _euclideanParams.steps + _euclideanParams.pad) {
+        _euclideanStepIndex = 0;
+    }
+    return (activeStep && shouldTrigger) ? TickEvent::TickStart : TickEvent::TickSkip;
+}
 
-        case EnvelopeState::Decay: {
-            float normalizedTime = currentTime / _envParams.decay;
-            float curvedTime = ApplyCurve(normalizedTime, _envParams.decayCurve);
-            float sustainLevel = MaxWaveValue * (_envParams.sustain / 100.0f);
-            _waveValue = MaxWaveValue - ((MaxWaveValue - sustainLevel) * curvedTime);
+// Step the phase by one master tick and find the pulse edge that falls on it. A pulse start takes
+// precedence over the end of the previous pulse, probability and Euclidean steps are left to the caller.
+TickEvent OutputCore::AdvancePhase(int PPQN, unsigned long globalTick) {
+    const PulseSchedule &schedule = _schedules[_activeSchedule];
 
-            if (currentTime >= _envParams.decay) {
-                _envState = EnvelopeState::Sustain;
-                _lastEnvValue = _waveValue;
-            }
-        } break;
+    // Line the phase up with the master clock when it starts and when the tick count jumps
+    if (globalTick == 0 || _resyncPending) {
+        _resyncPending = false;
+        ResyncPhase(PPQN, schedule.ratio, globalTick);
+    }
 
-        case EnvelopeState::Sustain:
-            _waveValue = MaxWaveValue * (_envParams.sustain / 100.0f);
-            break;
+    uint32_t phase = _phaseAccumulator;
+    uint32_t step = schedule.increment;
+    _phaseRemainder += schedule.remainder;
+    if (_phaseRemainder >= schedule.modulus) {
+        _phaseRemainder -= schedule.modulus;
+        step++;
+    }
+    _phaseAccumulator = phase + step;
 
-        case EnvelopeState::Release: {
-            float normalizedTime = currentTime / _envParams.release;
-            float curvedTime = ApplyCurve(normalizedTime, _envParams.releaseCurve);
-            _waveValue = _lastEnvValue * (1.0f - curvedTime);
+    // An edge falls on this tick if its phase lies between the current phase and the next one
+    bool pulseEnd = false;
+    if (_pulsePending && uint64_t(phase - _pulseStartPhase) + step > schedule.dutyPhase) {
+        _pulsePending = false;
+        pulseEnd = true;
+    }
+    bool pulseStart = false;
+    if (uint32_t(schedule.offsetPhase - phase) < step) {
+        // Delay every n-th period by the swing amount
+        _swingPending = schedule.swingPhase != 0 && (_cycleCount % schedule.swingEvery == 0);
+        _cycleCount++;
+        if (!_swingPending) {
+            pulseStart = true;
+            _pulseStartPhase = schedule.offsetPhase;
+        }
+    }
+    if (_swingPending && uint32_t(schedule.offsetPhase + schedule.swingPhase - phase) < step) {
+        _swingPending = false;
+        pulseStart = true;
+        _pulseStartPhase = schedule.offsetPhase + schedule.swingPhase;
+    }
+    if (pulseStart) {
+        _pulsePending = true;
+        return TickEvent::TickStart;
+    }
+    return pulseEnd ? TickEvent::TickStop : TickEvent::TickIdle;
+}
 
-            if (currentTime >= _envParams.release) {
-                _waveActive = false;
-                _envState = EnvelopeState::Idle;
-                _lastEnvValue = 0;
-            }
-        } break;
+// Snap the phase to where the output would be after the given number of master ticks, matching the
+// accumulator and its carried remainder exactly as if it had counted up from tick 0
+void OutputCore::ResyncPhase(int PPQN, ClockRatio ratio, unsigned long tick) {
+    uint32_t modulus = uint32_t(PPQN) * ratio.divisor;
+    uint32_t tickInCycle = tick % modulus;
+    uint64_t position = uint64_t((tickInCycle * ratio.multiplier) % modulus) << 32;
+    _phaseAccumulator = position / modulus;
+    _phaseRemainder = position % modulus;
+    _cycleCount = (tick / modulus) * ratio.multiplier + (tickInCycle * ratio.multiplier) / modulus;
+    _swingPending = false;
+}
 
-        default:
-            break;
-        }
-        _waveValue = constrain(_waveValue, 0, MaxWaveValue);
+// Work out the timing schedule into the spare buffer and swap it in for the clock ISR
+void OutputCore::UpdateSchedule(int PPQN) {
+    _scheduleDirty = false;
+    PulseSchedule &schedule = _schedules[_activeSchedule ^ 1];
+    schedule.ratio = _clockRatios[_dividerIndex];
+
+    // The phase advances by multiplier / (divisor * PPQN) of a turn per tick. The increment is split
+    // into a whole part and a remainder that is carried over, so a period lands exactly on its tick.
+    uint64_t turns = uint64_t(schedule.ratio.multiplier) << 32;
+    schedule.modulus = uint32_t(PPQN) * schedule.ratio.divisor;
+    schedule.increment = turns / schedule.modulus;
+    schedule.remainder = turns % schedule.modulus;
+
+    // Phase offset, duty cycle and swing as fractions of a turn
+    schedule.offsetPhase = (uint64_t(_phase) << 32) / 100;
+    schedule.dutyPhase = (uint64_t(_dutyCycle) << 32) / 100;
+    uint32_t swingTicks = _swingAmounts[_swingAmountIndex] * PPQN / 96; // Since our swing is in 96th notes
+    schedule.swingPhase = swingTicks * turns / schedule.modulus;
+    schedule.swingEvery = _swingEvery;
+
+    _activeSchedule ^= 1;
+    _scheduleVersion++;
+}
+
+// Check if the pulse state has changed
+bool OutputCore::HasPulseChanged() {
+    bool pulseChanged = (_isPulseOn != _lastPulseState);
+    _lastPulseState = _isPulseOn;
+    return pulseChanged;
+}
+
+// Master stop, stops the output but on resume it goes back to its previous state. Returns true if the
+// master state changed.
+bool OutputCore::ChangeMasterState(bool state) {
+    if (_masterState == state) {
+        return false;
     }
-};
+    _masterState = state;
+
+    // Reset the counters when state changes
+    _euclideanStepIndex = 0;
+
+    if (!_masterState) {
+        _oldState = _state;
+        _state = false;
+    } else {
+        _state = _oldState;
+    }
+    return true;
+}
+
+// Euclidean Rhythm Functions
+void OutputCore::SetEuclidean(bool enabled) {
+    _euclideanParams.enabled = enabled;
+    if (_euclideanParams.enabled) {
+        _euclideanRhythm = GeneratePattern(_euclideanParams);
+    }
+}
+
+// Set the number of steps in the Euclidean rhythm
+void OutputCore::SetEuclideanSteps(int steps) {
+    _euclideanParams.steps = constrain(steps, 1, MaxEuclideanSteps);
+    // Ensure that the number of triggers is less than the number of steps
+    if (_euclideanParams.triggers > _euclideanParams.steps) {
+        _euclideanParams.triggers = _euclideanParams.steps;
+    }
+    if (_euclideanParams.pad > MaxEuclideanSteps - _euclideanParams.steps) {
+        _euclideanParams.pad = MaxEuclideanSteps - _euclideanParams.steps;
+    }
+    if (_euclideanParams.enabled) {
+        _euclideanRhythm = GeneratePattern(_euclideanParams);
+    }
+}
+
+// Set the number of triggers in the Euclidean rhythm
+void OutputCore::SetEuclideanTriggers(int triggers) {
+    _euclideanParams.triggers = constrain(triggers, 1, _euclideanParams.steps);
+    if (_euclideanParams.enabled) {
+        _euclideanRhythm = GeneratePattern(_euclideanParams);
+    }
+}
+
+// Set the rotation of the Euclidean rhythm
+void OutputCore::SetEuclideanRotation(int rotation) {
+    _euclideanParams.rotation = constrain(rotation, 0, _euclideanParams.steps - 1);
+    if (_euclideanParams.enabled) {
+        _euclideanRhythm = GeneratePattern(_euclideanParams);
+    }
+}
+
+void OutputCore::SetEuclideanPadding(int pad) {
+    _euclideanParams.pad = constrain(pad, 0, MaxEuclideanSteps - _euclideanParams.steps);
+    if (_euclideanParams.enabled) {
+        _euclideanRhythm = GeneratePattern(_euclideanParams);
+    }
+}
+
+// ---------------- Gate Output ----------------
+
+// Timing stage, runs inside the clock interrupt. The gate follows the edges straight away.
+void GateOutput::Pulse(int PPQN, unsigned long globalTick) {
+    TickEvent event = AdvancePhase(PPQN, globalTick);
+
+    // If not stopped, generate the pulse
+    if (!_state) {
+        _isPulseOn = false;
+        return;
+    }
+    if (event == TickEvent::TickStart) {
+        event = TriggerPulse();
+    }
+    if (event == TickEvent::TickStart) {
+        _isPulseOn = true;
+    } else if (event == TickEvent::TickStop) {
+        _isPulseOn = false;
+    }
+}
+
+// Render stage, only picks up schedule changes
+void GateOutput::Render(int PPQN) {
+    if (_scheduleDirty) {
+        UpdateSchedule(PPQN);
+    }
+    if (!_state) {
+        _isPulseOn = false;
+    }
+}
+
+// ---------------- DAC Output ----------------
 
 // Constructor
-Output::Output(int ID, OutputType type) {
-    _ID = ID;
-    _outputType = type;
-    GeneratePattern(_euclideanParams, _euclideanRhythm);
+DACOutput::Output(int ID) : OutputCore(ID, _dividerAmount - 1) {
+    static_assert(sizeof(_waveformGenerators) / sizeof(_waveformGenerators[0]) == WaveformTypeLength,
+                  "Every waveform type needs a generator");
     SetupQuantizer();
 }
 
 // Setup quantizer scale and buffer
-void Output::SetupQuantizer() {
+void DACOutput::SetupQuantizer() {
     BuildScale(_quantizerParams.scaleIndex, _quantizerParams.noteIndex, _activeNotes);
     BuildQuantBuffer(_activeNotes, _quantizerThresholdBuff);
 }
 
-// Generate envelope based on trigger state
-void Output::GenEnvelope() {
+// Generate envelope based on trigger state, called once per control tick
+void DACOutput::GenEnvelope() {
+    // Gate edges from the CV inputs are applied here, so the envelope state is only written from one place.
+    // If both edges came in since the last tick, the one matching the current gate state came last.
+    if (_releasePending && _externaltrigger) {
+        _releasePending = false;
+        HandleGateRelease();
+    }
+    if (_triggerPending) {
+        _triggerPending = false;
+        HandleTrigger();
+    }
+    if (_releasePending) {
+        _releasePending = false;
+        HandleGateRelease();
+    }
+
     // Handle envelope generation based on trigger state
     if (_triggerMode) {
         switch (_waveformType) {
         case WaveformType::ADEnvelope:
-            GenerateADEnvelope();
-            break;
         case WaveformType::AREnvelope:
-            GenerateAREnvelope();
-            break;
         case WaveformType::ADSREnvelope:
-            GenerateADSREnvelope();
+            AdvanceEnvelope();
             break;
         default:
             // Handle other waveforms as before
@@ -944,49 +1357,59 @@ void Output::GenEnvelope() {
     }
 }
 
-void Output::GeneratePulse(int PPQN, unsigned long globalTick) {
-    bool shouldTrigger = (random(100) < _pulseProbability);
-    if (!_euclideanParams.enabled) {
-        // If not using Euclidean rhythm, generate waveform based on the pulse probability
-        if (shouldTrigger) {
-            StartWaveform();
-        } else {
-            // We stop the waveform directly if the pulse probability is not met since StopWaveform() is used for the square wave
-            ResetWaveform();
-        }
-    } else {
-        // If using Euclidean rhythm, check if the current step is active
-        if (_euclideanRhythm[_euclideanStepIndex] == 1) {
-            // Active step in the pattern
-            if (shouldTrigger) {
-                StartWaveform();
-            } else {
-                ResetWaveform();
-            }
-        } else {
-            // Inactive step in the pattern
-            ResetWaveform();
-        }
+// Timing stage, runs inside the clock interrupt. It only works out where the pulse edges fall,
+// the waveform itself is rendered by Render() outside of the interrupt.
+void DACOutput::Pulse(int PPQN, unsigned long globalTick) {
+    TickEvent event = AdvancePhase(PPQN, globalTick);
 
-        _euclideanStepIndex++;
-        // Restart the Euclidean rhythm if it reaches the end
-        if (_euclideanStepIndex >= _euclideanParams.steps + _euclideanParams.pad) {
-            _euclideanStepIndex = 0;
+    // If not stopped, generate the pulse
+    if (!_state) {
+        if (_waveformType == WaveformType::Square) {
+            StopWaveform();
         }
+        return;
+    }
+    // The reset pulse is controlled entirely by SetMasterState and ended by Render()
+    if (_waveformType == WaveformType::ResetTrig) {
+        return;
+    }
+
+    if (event == TickEvent::TickStart) {
+        _waveformStartPhase = _pulseStartPhase;
+        event = TriggerPulse();
+    }
+    if (event == TickEvent::TickIdle) {
+        return;
+    }
+
+    if (_waveformType == WaveformType::Square) {
+        // Square waves have nothing to render, so their edges are applied straight away
+        ApplyTickEvent(event);
+    } else {
+        QueueTickEvent(event);
     }
 }
 
-void Output::Pulse(int PPQN, unsigned long globalTick) {
-    // If not stopped, generate the pulse
+// Render stage, runs at a fixed control rate outside of the clock interrupt. Applies the edges
+// queued by Pulse() and evaluates the waveform at the current phase.
+void DACOutput::Render(int PPQN) {
+    if (_scheduleDirty) {
+        UpdateSchedule(PPQN);
+    }
+
+    while (_tickQueueTail != _tickQueueHead) {
+        TickEvent event = TickEvent(_tickQueue[_tickQueueTail]);
+        _tickQueueTail = (_tickQueueTail + 1) % TickQueueSize;
+        ApplyTickEvent(event);
+    }
+
     if (!_state) {
         StopWaveform();
         return;
     }
 
-    // Special handling for ResetTrig - we don't want it to follow normal clock timing
+    // Just check if we need to end the reset pulse after its duration
     if (_waveformType == WaveformType::ResetTrig) {
-        // The reset pulse is controlled entirely by SetMasterState
-        // Just check if we need to end the pulse after duration
         if (_isPulseOn && (millis() - _resetPulseStart >= 10)) {
             _waveValue = 0;
             _isPulseOn = false;
@@ -995,99 +1418,19 @@ void Output::Pulse(int PPQN, unsigned long globalTick) {
         return;
     }
 
-    // Calculate the period duration in ticks
-    float periodTicks = PPQN / _clockDividers[_dividerIndex];
-
-    // Calculate the phase offset in ticks
-    unsigned long phaseOffsetTicks = periodTicks * (_phase / 100.0);
-
-    // Apply swing to the tick counter
-    unsigned long tickCounterSwing = globalTick;
+    // Evaluate the waveform generator at the current phase
+    (this->*_waveformGenerators[_waveformType])(WaveformPhase());
+}
 
-    // Calculate the tick counter with swing applied
-    if (int(globalTick / periodTicks) % _swingEvery == 0) {
-        tickCounterSwing = globalTick - (_swingAmounts[_swingAmountIndex] * PPQN / 96); // Since our swing is in 96th notes
+void DACOutput::SetWaveformType(WaveformType type) {
+    // Saved settings and CV can hold anything, the generators are looked up by type
+    if (int(type) < 0 || int(type) >= WaveformTypeLength) {
+        type = WaveformType::Square;
     }
-
-    // Calculate the clock divider for external clock
-    int clockDividerExternal = 1 / _clockDividers[_dividerIndex];
-
-    // Calculate the pulse duration (in ticks) based on the duty cycle
-    unsigned int _pulseDuration = int(periodTicks * (_dutyCycle / 100.0));
-    unsigned int _externalPulseDuration = int(clockDividerExternal * (_dutyCycle / 100.0));
-
-    // If using an external clock, generate a pulse based on the internal pulse counter
-    // dirty workaround to make this work with clock dividers
-    if (_externalClock && _clockDividers[_dividerIndex] < 1) {
-        if (_internalPulseCounter % clockDividerExternal == 0 || _internalPulseCounter == 0) {
-            GeneratePulse(PPQN, globalTick);
-        } else if (_internalPulseCounter % clockDividerExternal == _externalPulseDuration) {
-            StopWaveform();
-        }
-    } else {
-        // Handle internal clock timing
-        if ((tickCounterSwing - phaseOffsetTicks) % int(periodTicks) == 0 || (globalTick == 0)) {
-            GeneratePulse(PPQN, globalTick);
-        } else if ((tickCounterSwing - phaseOffsetTicks) % int(periodTicks) == _pulseDuration) {
-            StopWaveform();
-        }
+    // Only the output on the internal DAC can run at audio rate, the others get the sine at clock rate
+    if (type == WaveformType::Oscillator && !_audioCapable) {
+        type = WaveformType::Sine;
     }
-    // Handle the waveform generation
-    switch (_waveformType) {
-    case WaveformType::Triangle:
-        GenerateTriangleWave(PPQN);
-        break;
-    case WaveformType::Sine:
-        GenerateSineWave(PPQN);
-        break;
-    case WaveformType::Parabolic:
-        GenerateParabolicWave(PPQN);
-        break;
-    case WaveformType::Sawtooth:
-        GenerateSawtoothWave(PPQN);
-        break;
-    case WaveformType::Noise:
-        GenerateNoiseWave(PPQN);
-        break;
-    case WaveformType::SmoothNoise:
-        GenerateSmoothNoiseWave(PPQN);
-        break;
-    case WaveformType::ExpEnvelope:
-        GenerateExpEnvelope(PPQN);
-        break;
-    case WaveformType::LogEnvelope:
-        GenerateLogEnvelope(PPQN);
-        break;
-    case WaveformType::InvExpEnvelope:
-        GenerateInvExpEnvelope(PPQN);
-        break;
-    case WaveformType::InvLogEnvelope:
-        GenerateInvLogEnvelope(PPQN);
-        break;
-    case WaveformType::SampleHold:
-        GenerateSampleHold(PPQN);
-        break;
-    case WaveformType::Play:
-        if (_waveActive) {
-            _waveValue = MaxWaveValue;
-            _isPulseOn = true;
-        } else {
-            _waveValue = 0;
-            _isPulseOn = false;
-        }
-        break;
-    case WaveformType::QuantizeInput:
-        _waveValue = (_inputCV / MaxDACValue) * MaxWaveValue;
-        _isPulseOn = true;
-        break;
-
-    default:
-        // For square wave or other types
-        break;
-    }
-}
-
-void Output::SetWaveformType(WaveformType type) {
     // If reverting from a trigger to a waveform, reset the divider to x1
     if (((_waveformType == WaveformType::ADEnvelope) ||
          (_waveformType == WaveformType::AREnvelope) ||
@@ -1103,8 +1446,7 @@ void Output::SetWaveformType(WaveformType type) {
         _waveActive = false;
         _envState = EnvelopeState::Idle;
         _waveValue = 0.0f;
-        _lastEnvValue = 0.0f;
-        _envStartTime = 0;
+        _envTicksLeft = 0;
         _triggerMode = true;
         SetDivider(18);
     } else if (_waveformType == WaveformType::QuantizeInput) {
@@ -1122,121 +1464,73 @@ void Output::SetWaveformType(WaveformType type) {
     }
 }
 
-// Check if the pulse state has changed
-bool Output::HasPulseChanged() {
-    bool pulseChanged = (_isPulseOn != _lastPulseState);
-    _lastPulseState = _isPulseOn;
-    return pulseChanged;
-}
-
-void Output::SetMasterState(bool state) {
-    if (_masterState != state) {
-        _masterState = state;
-
-        // Reset all counters when state changes
-        _internalPulseCounter = 0;
-        _envTickCounter = 0;
-        _randomTickCounter = 0;
-        _euclideanStepIndex = 0;
-
-        if (!_masterState) {
-            _oldState = _state;
-            _state = false;
-            if (_waveformType == WaveformType::ResetTrig) {
-                _waveValue = 0;
-                _isPulseOn = false;
-                _waveActive = false;
-            }
-        } else {
-            _state = _oldState;
-            // Only generate reset pulse when transitioning to true
-            if (_waveformType == WaveformType::ResetTrig) {
-                _waveValue = MaxWaveValue;
-                _resetPulseStart = millis();
-                _isPulseOn = true;
-                _waveActive = true;
-            }
-        }
+// Fill a block of 10-bit samples for the audio oscillator. It runs AudioOctaves above the output's clock
+// rate, or fewer if that would go past 4 kHz, and is pulled towards the output's phase on every block so
+// it stays locked to the clock. ticksPerSample is the sample period in master ticks.
+void DACOutput::FillAudioBlock(int PPQN, float ticksPerSample, uint16_t *samples, int count) {
+    const PulseSchedule &schedule = _schedules[_activeSchedule];
+    float cyclesPerSample = ticksPerSample * schedule.ratio.multiplier / (float(PPQN) * schedule.ratio.divisor);
+    int octaves = AudioOctaves;
+    while (octaves > 0 && cyclesPerSample * (1 << octaves) > 0.125f) {
+        octaves--;
     }
-}
-
-// Master stop, stops all outputs but on resume, the outputs will resume to previous state
-void Output::ToggleMasterState() {
-    SetMasterState(!_masterState);
-}
-
-// Output Level based on the output type and pulse state
-uint32_t Output::GetOutputLevel() {
-    float adjustedLevel;
-    float outputLevel;
-
-    if (_outputType == OutputType::DigitalOut) {
-        return _isPulseOn ? HIGH : LOW;
-    } else {
-        if (_waveformType == WaveformType::Square) {
-            adjustedLevel = _isPulseOn ? (MaxWaveValue * (_level / 100.0)) + ((_offset / 100.0) * MaxWaveValue) : _offset;
-            adjustedLevel = constrain(adjustedLevel, 0, MaxWaveValue);
-        } else {
-            // Take into account the wave value and the _level and _offset values
-            adjustedLevel = _waveValue * (_level / 100.0) + (_offset / 100.0) * MaxWaveValue;
-            adjustedLevel = constrain(adjustedLevel, 0, MaxWaveValue);
-            adjustedLevel = _isPulseOn ? adjustedLevel : _offset;
+    int32_t increment = cyclesPerSample * (1 << octaves) * 4294967296.0f;
+    int32_t error = int32_t((_phaseAccumulator << octaves) - _audioPhase);
+    increment += error / count / 8;
+
+    int32_t level = _level * 1023 / 100;
+    int32_t offset = _offset * 1023 / 100;
+    for (int i = 0; i < count; i++) {
+        int32_t value = offset;
+        if (_state) {
+            value += ((SineQ15(_audioPhase) + 32768) * level) >> 16;
         }
-
-        outputLevel = adjustedLevel * MaxDACValue / MaxWaveValue;
-
-        if (_quantizerParams.enable) {
-            // Apply quantization
-            QuantizeCV(outputLevel, _oldOutputLevel, _quantizerThresholdBuff, _quantizerParams.channelSensitivity, _quantizerParams.octaveShift, &outputLevel);
-        }
-
-        _oldOutputLevel = outputLevel;
-        return uint32_t(outputLevel);
+        samples[i] = constrain(value, 0, 1023);
+        _audioPhase += increment;
     }
 }
 
-// Euclidean Rhythm Functions
-void Output::SetEuclidean(bool enabled) {
-    _euclideanParams.enabled = enabled;
-    if (_euclideanParams.enabled) {
-        GeneratePattern(_euclideanParams, _euclideanRhythm);
+void DACOutput::SetMasterState(bool state) {
+    if (!ChangeMasterState(state)) {
+        return;
     }
-}
+    _randomTickCounter = 0;
 
-// Set the number of steps in the Euclidean rhythm
-void Output::SetEuclideanSteps(int steps) {
-    _euclideanParams.steps = constrain(steps, 1, MaxEuclideanSteps);
-    // Ensure that the number of triggers is less than the number of steps
-    if (_euclideanParams.triggers > _euclideanParams.steps) {
-        _euclideanParams.triggers = _euclideanParams.steps;
-    }
-    if (_euclideanParams.pad > MaxEuclideanSteps - _euclideanParams.steps) {
-        _euclideanParams.pad = MaxEuclideanSteps - _euclideanParams.steps;
+    if (_waveformType != WaveformType::ResetTrig) {
+        return;
     }
-    if (_euclideanParams.enabled) {
-        GeneratePattern(_euclideanParams, _euclideanRhythm);
+    if (!_masterState) {
+        _waveValue = 0;
+        _isPulseOn = false;
+        _waveActive = false;
+    } else {
+        // Only generate reset pulse when transitioning to true
+        _waveValue = MaxWaveValue;
+        _resetPulseStart = millis();
+        _isPulseOn = true;
+        _waveActive = true;
     }
 }
 
-// Set the number of triggers in the Euclidean rhythm
-void Output::SetEuclideanTriggers(int triggers) {
-    _euclideanParams.triggers = constrain(triggers, 1, _euclideanParams.steps);
-    if (_euclideanParams.enabled) {
-        GeneratePattern(_euclideanParams, _euclideanRhythm);
+// Output Level based on the waveform and pulse state
+// The level and offset are applied in integer Q12 with the multipliers worked out when they were set,
+// so the result is the same on every build and needs no float library calls on the M0+. While the
+// pulse is off the output holds the offset voltage, so an offset of 50% rests at 2.5V.
+uint32_t DACOutput::GetOutputLevel() {
+    int32_t outputLevel = _offsetLevel;
+    if (_isPulseOn) {
+        // The wave in DAC steps, rounded once on the way in
+        int32_t wave = (_waveformType == WaveformType::Square) ? MaxDACValue : int32_t(_waveValue * (MaxDACValue / MaxWaveValue) + 0.5f);
+        outputLevel = constrain(((wave * _levelScale + 2048) >> 12) + _offsetLevel, 0, MaxDACValue);
     }
-}
 
-// Set the rotation of the Euclidean rhythm
-void Output::SetEuclideanRotation(int rotation) {
-    _euclideanParams.rotation = constrain(rotation, 0, _euclideanParams.steps - 1);
-    if (_euclideanParams.enabled) {
-        GeneratePattern(_euclideanParams, _euclideanRhythm);
+    if (_quantizerParams.enable) {
+        // Apply quantization
+        float quantizedLevel = outputLevel; // Left as it is when the input did not move enough
+        QuantizeCV(outputLevel, _oldOutputLevel, _quantizerThresholdBuff, _quantizerParams.channelSensitivity, _quantizerParams.octaveShift, &quantizedLevel);
+        outputLevel = quantizedLevel;
     }
-}
 
-void Output::SetEuclideanPadding(int pad) {
-    _euclideanParams.pad = constrain(pad, 0, MaxEuclideanSteps - _euclideanParams.steps);
-    if (_euclideanParams.enabled) {
-        GeneratePattern(_euclideanParams, _euclideanRhythm);
-    }
+    _oldOutputLevel = outputLevel;
+    return uint32_t(outputLevel);
 }
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+#include "clocksync.hpp"
+
+// Runs a tick timer against an external clock the way ClockPulse() and ClockReceived() do,
+// the ticks hold at the tick limit and follow the tick period set on every edge
+class ClockSyncTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        clockSync.SetTicksPerPulse(48);
+        srand(1);
+    }
+
+    // Feed one edge after the given interval and return the jump, if any
+    long Edge(unsigned long interval) {
+        unsigned long edgeTime = now + interval;
+        while (clockSync.IsLocked() && nextTick <= edgeTime) {
+            if (tickCounter < clockSync.GetTickLimit()) {
+                tickCounter++;
+            }
+            nextTick += clockSync.GetTickPeriod();
+        }
+        now = edgeTime;
+        long jump = clockSync.Edge(now, tickCounter);
+        if (jump != ClockSync::NoJump) {
+            tickCounter = jump;
+        }
+        if (clockSync.IsLocked() && nextTick < now) {
+            nextTick = now + clockSync.GetTickPeriod();
+        }
+        return jump;
+    }
+
+    unsigned long Jitter(unsigned long amount) { return rand() % (2 * amount + 1) - amount; }
+
+    ClockSync clockSync;
+    unsigned long now = 1000;
+    unsigned long tickCounter = 0;
+    double nextTick = 0;
+};
+
+// A jittery clock is followed without restarting the tick count
+TEST_F(ClockSyncTest, LocksToJitteryClock) {
+    const unsigned long period = 125000; // 16th notes at 120 BPM
+    EXPECT_EQ(Edge(0), 0);
+    for (int i = 0; i < 8; i++) {
+        Edge(period + Jitter(2000));
+    }
+    for (int i = 0; i < 200; i++) {
+        EXPECT_EQ(Edge(period + Jitter(2000)), ClockSync::NoJump);
+        EXPECT_NEAR(long(tickCounter % 48 + 24) % 48, 24, 2); // Within two ticks of the edge
+    }
+    EXPECT_NEAR(clockSync.GetTickPeriod(), period / 48.0, period / 48.0 * 0.05);
+}
+
+// Tempo changes are followed within a few edges
+TEST_F(ClockSyncTest, FollowsTempoChange) {
+    Edge(0);
+    for (int i = 0; i < 20; i++) {
+        Edge(125000);
+    }
+    for (int i = 0; i < 30; i++) {
+        Edge(100000);
+    }
+    EXPECT_NEAR(clockSync.GetPulsePeriod(), 100000, 100);
+    EXPECT_EQ(tickCounter % 48, 0ul);
+    EXPECT_NEAR(clockSync.GetTickPeriod(), 100000 / 48.0, 2.0);
+}
+
+// Changing the input division starts the count again from the next edge
+TEST_F(ClockSyncTest, DividerChangeRestarts) {
+    Edge(0);
+    for (int i = 0; i < 10; i++) {
+        Edge(125000);
+    }
+    clockSync.SetTicksPerPulse(96);
+    EXPECT_EQ(Edge(125000), 0);
+    EXPECT_EQ(clockSync.GetTickLimit(), 96ul);
+}
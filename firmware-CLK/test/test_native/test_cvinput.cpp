@@ -0,0 +1,37 @@
+#include <gtest/gtest.h>
+
+#include "cvinput.hpp"
+
+// A step should reach 63% after one time constant, whatever the time constant is
+TEST(CVInputTest, StepFollowsTimeConstant) {
+    for (float timeConstant : {2.0f, 5.0f, 20.0f}) {
+        CVInput input(timeConstant, 0);
+        int32_t value = 0;
+        for (int i = 0; i < timeConstant * CV_RATE / 1000; i++) {
+            value = input.Process(4000);
+        }
+        EXPECT_NEAR(value, 4000 * 0.632f, 4000 * 0.05f) << "Time constant " << timeConstant;
+    }
+}
+
+TEST(CVInputTest, SettlesOnSteadyInput) {
+    CVInput input;
+    for (int i = 0; i < CV_RATE; i++) {
+        input.Process(2000);
+    }
+    EXPECT_NEAR(input.GetValue(), 2000, CV_HYSTERESIS);
+}
+
+// Noise within the hysteresis never reaches the output
+TEST(CVInputTest, HoldsThroughNoise) {
+    CVInput input(CV_FILTER_TIME, 4);
+    input.Reset(1000);
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(input.Process(1000 + ((i & 1) ? 3 : -3)), 1000);
+    }
+    // A real move still gets through
+    for (int i = 0; i < 100; i++) {
+        input.Process(1100);
+    }
+    EXPECT_EQ(input.GetValue(), 1096);
+}
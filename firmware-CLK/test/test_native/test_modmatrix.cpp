@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include "modmatrix.hpp"
+
+class ModMatrixTest : public ::testing::Test {
+  protected:
+    // Record the last value written to each target and how often it was written
+    static void Apply(uint8_t target, int32_t value) {
+        values[target] = value;
+        writes[target]++;
+    }
+
+    void SetUp() override {
+        for (int i = 0; i < 8; i++) {
+            values[i] = -1;
+            writes[i] = 0;
+        }
+    }
+
+    ModMatrix matrix;
+    static int32_t values[8];
+    static int writes[8];
+};
+
+int32_t ModMatrixTest::values[8];
+int ModMatrixTest::writes[8];
+
+TEST_F(ModMatrixTest, FullRangeMapsOntoTarget) {
+    matrix.AddRoute(0, 1, 0, 0, 1, 100);
+    const ModMatrix::Route &route = matrix.GetRoute(0);
+    EXPECT_EQ(ModMatrix::Evaluate(route, 0), 1);
+    EXPECT_EQ(ModMatrix::Evaluate(route, MOD_INPUT_MAX), 100);
+    EXPECT_EQ(ModMatrix::Evaluate(route, 2048), 51);
+}
+
+TEST_F(ModMatrixTest, AttenuationAndOffset) {
+    // Half the gain, a quarter of the range added on top
+    matrix.AddRoute(0, 1, 50, 25, 0, MOD_INPUT_MAX);
+    const ModMatrix::Route &route = matrix.GetRoute(0);
+    EXPECT_NEAR(ModMatrix::Evaluate(route, 0), 1023, 1);
+    EXPECT_NEAR(ModMatrix::Evaluate(route, MOD_INPUT_MAX), 3070, 2);
+    // The bias can push the input past full scale, the result stays in range
+    matrix.AddRoute(0, 2, 0, 100, 0, 10);
+    EXPECT_EQ(ModMatrix::Evaluate(matrix.GetRoute(1), MOD_INPUT_MAX), 10);
+}
+
+TEST_F(ModMatrixTest, GateTargetSwitchesAtHalfScale) {
+    matrix.AddRoute(0, 1, 0, 0, 0, 1);
+    const ModMatrix::Route &route = matrix.GetRoute(0);
+    EXPECT_EQ(ModMatrix::Evaluate(route, 2047), 0);
+    EXPECT_EQ(ModMatrix::Evaluate(route, 2048), 1);
+}
+
+TEST_F(ModMatrixTest, OneInputDrivesSeveralTargets) {
+    matrix.AddRoute(0, 1, 0, 0, 1, 100);
+    matrix.AddRoute(0, 2, 0, 0, 1, 100);
+    matrix.AddRoute(1, 3, 0, 0, 0, 15);
+    matrix.Process(0, MOD_INPUT_MAX, Apply);
+    EXPECT_EQ(values[1], 100);
+    EXPECT_EQ(values[2], 100);
+    EXPECT_EQ(writes[3], 0);
+    matrix.Process(1, 0, Apply);
+    EXPECT_EQ(values[3], 0);
+}
+
+TEST_F(ModMatrixTest, OnlyChangesAreApplied) {
+    matrix.AddRoute(0, 1, 0, 0, 0, 1);
+    matrix.Process(0, 100, Apply);
+    matrix.Process(0, 200, Apply);
+    EXPECT_EQ(writes[1], 1);
+    matrix.Process(0, 3000, Apply);
+    EXPECT_EQ(writes[1], 2);
+    EXPECT_EQ(values[1], 1);
+}
+
+TEST_F(ModMatrixTest, RouteLimit) {
+    for (int i = 0; i < ModMatrix::MaxRoutes; i++) {
+        EXPECT_TRUE(matrix.AddRoute(0, i, 0, 0, 0, 1));
+    }
+    EXPECT_FALSE(matrix.AddRoute(0, 0, 0, 0, 0, 1));
+    matrix.Clear();
+    EXPECT_EQ(matrix.GetRouteCount(), 0);
+}
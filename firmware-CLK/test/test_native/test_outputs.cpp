@@ -5,8 +5,8 @@
 class OutputTest : public ::testing::Test {
   protected:
     void SetUp() override {
-        digitalOutput = new Output(0, OutputType::DigitalOut);
-        dacOutput = new Output(1, OutputType::DACOut);
+        digitalOutput = new GateOutput(0);
+        dacOutput = new DACOutput(1);
     }
 
     void TearDown() override {
@@ -15,14 +15,14 @@ class OutputTest : public ::testing::Test {
     }
 
     void AdvanceTime(unsigned long microseconds) {
-        // Simulate time advancement for envelope tests
-        for (int i = 0; i < microseconds / 1000; i++) {
+        // Simulate time advancement for envelope tests, one call per control tick
+        for (int i = 0; i < microseconds * CONTROL_RATE / 1000000; i++) {
             dacOutput->GenEnvelope();
         }
     }
 
-    Output *digitalOutput;
-    Output *dacOutput;
+    GateOutput *digitalOutput;
+    DACOutput *dacOutput;
 };
 
 // Constructor Tests
@@ -30,9 +30,17 @@ TEST_F(OutputTest, ConstructorInitialization) {
     EXPECT_EQ(digitalOutput->GetOutputState(), true);
     EXPECT_EQ(digitalOutput->GetDividerIndex(), 9); // Default x1
     EXPECT_EQ(digitalOutput->GetDutyCycle(), 50);
-    EXPECT_EQ(digitalOutput->GetLevel(), 100);
-    EXPECT_EQ(digitalOutput->GetOffset(), 0);
-    EXPECT_EQ(digitalOutput->GetWaveformType(), WaveformType::Square);
+    EXPECT_EQ(dacOutput->GetLevel(), 100);
+    EXPECT_EQ(dacOutput->GetOffset(), 0);
+    EXPECT_EQ(dacOutput->GetWaveformType(), WaveformType::Square);
+}
+
+// Gates have no envelope, the DAC outputs take every divider
+TEST_F(OutputTest, DividerRangeByOutputType) {
+    digitalOutput->SetDivider(DividerAmount - 1);
+    EXPECT_EQ(digitalOutput->GetDividerIndex(), DividerAmount - 2);
+    dacOutput->SetDivider(DividerAmount - 1);
+    EXPECT_EQ(dacOutput->GetDividerIndex(), DividerAmount - 1);
 }
 
 // Basic Output State Tests
@@ -85,60 +93,70 @@ TEST_F(OutputTest, WaveformTypeControl) {
 }
 
 // Envelope Tests
-// TEST_F(OutputTest, EnvelopeGenerationWithoutRetrigger) {
-//     dacOutput->SetWaveformType(WaveformType::ADSREnvelope);
-//     dacOutput->SetAttack(100);  // 100ms attack
-//     dacOutput->SetDecay(100);   // 100ms decay
-//     dacOutput->SetSustain(70);  // 70% sustain
-//     dacOutput->SetRelease(100); // 100ms release
-//     dacOutput->SetRetrigger(false);
-
-//     // Trigger envelope
-//     dacOutput->SetExternalTrigger(true);
-
-//     // Check attack phase
-//     AdvanceTime(50000); // 50ms into attack
-//     float midAttackValue = dacOutput->GetOutputLevel();
-//     EXPECT_GT(midAttackValue, 0);
-//     EXPECT_LT(midAttackValue, 4095);
-
-//     // Complete attack and into decay
-//     AdvanceTime(150000);
-//     float sustainValue = dacOutput->GetOutputLevel();
-//     EXPECT_NEAR(sustainValue, 4095 * 0.7, 100); // Should be near 70% sustain level
-
-//     // Release
-//     dacOutput->SetExternalTrigger(false);
-//     AdvanceTime(50000); // 50ms into release
-//     float midReleaseValue = dacOutput->GetOutputLevel();
-//     EXPECT_LT(midReleaseValue, sustainValue);
-
-//     // Trigger again during release - should not retrigger
-//     dacOutput->SetExternalTrigger(true);
-//     AdvanceTime(10000);
-//     EXPECT_LT(dacOutput->GetOutputLevel(), midReleaseValue);
-// }
+TEST_F(OutputTest, EnvelopeGenerationWithoutRetrigger) {
+    dacOutput->SetWaveformType(WaveformType::ADSREnvelope);
+    dacOutput->SetAttack(100);  // 100ms attack
+    dacOutput->SetDecay(100);   // 100ms decay
+    dacOutput->SetSustain(70);  // 70% sustain
+    dacOutput->SetRelease(100); // 100ms release
+    dacOutput->SetRetrigger(false);
+
+    // Trigger envelope
+    dacOutput->SetExternalTrigger(true);
+
+    // Check attack phase
+    AdvanceTime(50000); // 50ms into attack
+    float midAttackValue = dacOutput->GetOutputLevel();
+    EXPECT_GT(midAttackValue, 0);
+    EXPECT_LT(midAttackValue, 4095);
+
+    // Complete attack and into decay
+    AdvanceTime(150000);
+    float sustainValue = dacOutput->GetOutputLevel();
+    EXPECT_NEAR(sustainValue, 4095 * 0.7, 100); // Should be near 70% sustain level
+
+    // Release
+    dacOutput->SetExternalTrigger(false);
+    AdvanceTime(50000); // 50ms into release
+    float midReleaseValue = dacOutput->GetOutputLevel();
+    EXPECT_LT(midReleaseValue, sustainValue);
+
+    // Trigger again during release - should not retrigger
+    dacOutput->SetExternalTrigger(true);
+    AdvanceTime(10000);
+    EXPECT_LT(dacOutput->GetOutputLevel(), midReleaseValue);
+}
 
-// TEST_F(OutputTest, EnvelopeGenerationWithRetrigger) {
-//     dacOutput->SetWaveformType(WaveformType::ADSREnvelope);
-//     dacOutput->SetAttack(100);
-//     dacOutput->SetDecay(100);
-//     dacOutput->SetSustain(70);
-//     dacOutput->SetRelease(100);
-//     dacOutput->SetRetrigger(true);
-
-//     // Initial trigger
-//     dacOutput->SetExternalTrigger(true);
-//     AdvanceTime(150000); // Into decay phase
-//     float firstValue = dacOutput->GetOutputLevel();
-
-//     // Retrigger
-//     dacOutput->SetExternalTrigger(false);
-//     dacOutput->SetExternalTrigger(true);
-//     AdvanceTime(50000);
-//     float retriggeredValue = dacOutput->GetOutputLevel();
-//     EXPECT_GT(retriggeredValue, 0);
-// }
+TEST_F(OutputTest, EnvelopeGenerationWithRetrigger) {
+    dacOutput->SetWaveformType(WaveformType::ADSREnvelope);
+    dacOutput->SetAttack(100);
+    dacOutput->SetDecay(100);
+    dacOutput->SetSustain(70);
+    dacOutput->SetRelease(100);
+    dacOutput->SetRetrigger(true);
+
+    // Initial trigger
+    dacOutput->SetExternalTrigger(true);
+    AdvanceTime(150000); // Into decay phase
+    uint32_t firstValue = dacOutput->GetOutputLevel();
+
+    // Retrigger, the attack starts again from where the decay had got to rather than from zero
+    dacOutput->SetExternalTrigger(false);
+    dacOutput->SetExternalTrigger(true);
+    AdvanceTime(500); // One control tick
+    uint32_t lastValue = dacOutput->GetOutputLevel();
+    EXPECT_GE(lastValue, firstValue);
+    EXPECT_LT(lastValue, firstValue + 4095 / 100);
+
+    // And rises from there
+    for (int i = 0; i < 100; i++) {
+        AdvanceTime(500);
+        uint32_t value = dacOutput->GetOutputLevel();
+        EXPECT_GE(value, lastValue);
+        lastValue = value;
+    }
+    EXPECT_GT(lastValue, firstValue);
+}
 
 // Clock Division Tests
 // TEST_F(OutputTest, ClockDivision) {
@@ -160,6 +178,168 @@ TEST_F(OutputTest, WaveformTypeControl) {
 //     EXPECT_FALSE(digitalOutput->GetPulseState());
 // }
 
+// Count the rising edges over a number of master beats, rendering every tick
+template <typename OutputClass>
+int CountPulses(OutputClass *output, int PPQN, int beats) {
+    int pulses = 0;
+    bool lastState = false;
+    for (unsigned long tick = 0; tick < (unsigned long)(PPQN * beats); tick++) {
+        output->Render(PPQN);
+        output->Pulse(PPQN, tick);
+        if (output->GetPulseState() && !lastState)
+            pulses++;
+        lastState = output->GetPulseState();
+    }
+    return pulses;
+}
+
+// Fractional ratios land exactly on the master clock
+TEST_F(OutputTest, ClockRatiosAreExact) {
+    const int PPQN = 192;
+    digitalOutput->SetDivider(6); // /3
+    EXPECT_EQ(CountPulses(digitalOutput, PPQN, 300), 100);
+
+    GateOutput *output = new GateOutput(0);
+    output->SetDivider(10); // x1.5
+    EXPECT_EQ(CountPulses(output, PPQN, 300), 450);
+    delete output;
+}
+
+// Nothing fires before the render stage has built the first schedule
+TEST_F(OutputTest, IdleUntilFirstRender) {
+    const int PPQN = 24;
+    for (unsigned long tick = 0; tick < (unsigned long)PPQN; tick++) {
+        digitalOutput->Pulse(PPQN, tick);
+        EXPECT_FALSE(digitalOutput->GetPulseState());
+    }
+    EXPECT_EQ(digitalOutput->GetPulseStarts(), 0);
+}
+
+// Resyncing after a jump in the tick count lands on the same phase as counting up to it
+TEST_F(OutputTest, ResyncMatchesCountedPhase) {
+    const int PPQN = 192;
+    GateOutput *counted = new GateOutput(0);
+    GateOutput *jumped = new GateOutput(0);
+    counted->SetDivider(10); // x1.5
+    jumped->SetDivider(10);
+    counted->Render(PPQN);
+    jumped->Render(PPQN);
+    for (unsigned long tick = 0; tick < 1000; tick++) {
+        counted->Pulse(PPQN, tick);
+    }
+    jumped->Pulse(PPQN, 0);
+    jumped->Resync();
+    for (unsigned long tick = 1000; tick < 2000; tick++) {
+        counted->Pulse(PPQN, tick);
+        jumped->Pulse(PPQN, tick);
+        EXPECT_EQ(counted->GetPulseState(), jumped->GetPulseState());
+    }
+    delete counted;
+    delete jumped;
+}
+
+// The audio oscillator runs a fixed number of octaves above the output clock
+TEST_F(OutputTest, AudioOscillatorFrequency) {
+    const int PPQN = 192;
+    DACOutput *external = new DACOutput(2);
+    external->SetWaveformType(WaveformType::Oscillator);
+    EXPECT_EQ(external->GetWaveformType(), WaveformType::Sine); // Not on the internal DAC
+    delete external;
+
+    dacOutput->SetAudioCapable(true);
+    dacOutput->SetWaveformType(WaveformType::Oscillator);
+    dacOutput->Render(PPQN);
+    // 120 BPM at 32 kHz, the x1 output runs at 2 Hz so the oscillator at 512 Hz
+    float ticksPerSample = (1000000.0f / 32000) / (60.0f * 1000000 / 120 / PPQN);
+    uint16_t samples[64];
+    int crossings = 0;
+    uint16_t last = 512;
+    unsigned long tick = 0;
+    for (int block = 0; block < 500; block++) { // One second, with the clock running alongside
+        while (tick < (block + 1) * 64 * ticksPerSample) {
+            dacOutput->Pulse(PPQN, tick++);
+        }
+        dacOutput->FillAudioBlock(PPQN, ticksPerSample, samples, 64);
+        for (int i = 0; i < 64; i++) {
+            if (last < 512 && samples[i] >= 512)
+                crossings++;
+            last = samples[i];
+        }
+    }
+    EXPECT_NEAR(crossings, 512, 1);
+}
+
+// The sine rises over the duty cycle, so its peak moves with it
+TEST_F(OutputTest, SinePeakFollowsDutyCycle) {
+    const int PPQN = 192;
+    const int duties[] = {25, 50, 75};
+    for (int duty : duties) {
+        DACOutput *output = new DACOutput(1);
+        output->SetWaveformType(WaveformType::Sine);
+        output->SetDutyCycle(duty);
+        uint32_t peak = 0;
+        unsigned long peakTick = 0;
+        for (unsigned long tick = 0; tick < (unsigned long)PPQN; tick++) {
+            output->Render(PPQN);
+            output->Pulse(PPQN, tick);
+            output->Render(PPQN);
+            uint32_t level = output->GetOutputLevel();
+            if (level > peak) {
+                peak = level;
+                peakTick = tick;
+            }
+        }
+        EXPECT_NEAR(peak, 4095u, 1);
+        EXPECT_NEAR(peakTick, PPQN * duty / 100, 4); // The top is flat to within a DAC step
+        delete output;
+    }
+}
+
+// Noise takes a fixed number of values per output period, so its speed follows the divider
+TEST_F(OutputTest, NoiseFollowsDivider) {
+    const int PPQN = 192;
+    const int dividers[] = {7, 9}; // /2 and x1
+    const int expected[] = {256, 512};
+    for (int i = 0; i < 2; i++) {
+        DACOutput *output = new DACOutput(1);
+        output->SetWaveformType(WaveformType::Noise);
+        output->SetDivider(dividers[i]);
+        int changes = 0;
+        uint32_t last = 0;
+        for (unsigned long tick = 0; tick < (unsigned long)(PPQN * 4); tick++) {
+            output->Render(PPQN);
+            output->Pulse(PPQN, tick);
+            uint32_t level = output->GetOutputLevel();
+            if (level != last)
+                changes++;
+            last = level;
+        }
+        // A new value can match the last one now and then
+        EXPECT_NEAR(changes, expected[i], expected[i] / 32);
+        delete output;
+    }
+}
+
+// A fixed seed makes the probability pattern repeatable
+TEST_F(OutputTest, ProbabilityIsReproducible) {
+    const int PPQN = 24;
+    GateOutput *first = new GateOutput(0);
+    GateOutput *second = new GateOutput(0);
+    first->SetRandomSeed(1234);
+    second->SetRandomSeed(1234);
+    first->SetPulseProbability(50);
+    second->SetPulseProbability(50);
+    for (unsigned long tick = 0; tick < (unsigned long)(PPQN * 64); tick++) {
+        first->Render(PPQN);
+        second->Render(PPQN);
+        first->Pulse(PPQN, tick);
+        second->Pulse(PPQN, tick);
+        ASSERT_EQ(first->GetPulseState(), second->GetPulseState());
+    }
+    delete first;
+    delete second;
+}
+
 // Euclidean Pattern Tests
 TEST_F(OutputTest, EuclideanPatterns) {
     digitalOutput->SetEuclidean(true);
@@ -181,6 +361,34 @@ TEST_F(OutputTest, EuclideanPatterns) {
     EXPECT_EQ(triggerCount, 2);
 }
 
+// Patterns start on a trigger and rotate within their length
+TEST_F(OutputTest, EuclideanRotation) {
+    EuclideanParams params = {.enabled = true, .steps = 8, .triggers = 3, .rotation = 0, .pad = 0};
+    EXPECT_EQ(GeneratePattern(params), 0b01001001u); // x..x..x.
+    params.rotation = 1;
+    EXPECT_EQ(GeneratePattern(params), 0b10010010u);
+    params.rotation = 2;
+    EXPECT_EQ(GeneratePattern(params), 0b00100101u);
+}
+
+// The flash table holds evenly spread patterns for every steps/triggers pair
+TEST_F(OutputTest, EuclideanTable) {
+    for (int steps = 1; steps <= EuclideanMaxSteps; steps++) {
+        for (int triggers = 1; triggers <= steps; triggers++) {
+            EuclideanPattern pattern = euclideanTable.patterns[EuclideanTableIndex(steps, triggers)];
+            int count = 0;
+            for (int i = 0; i < 64; i++) {
+                if (PatternStep(pattern, i)) {
+                    ASSERT_LT(i, steps);
+                    EXPECT_LT((i * triggers) % steps, triggers);
+                    count++;
+                }
+            }
+            EXPECT_EQ(count, triggers);
+        }
+    }
+}
+
 // DAC Output Level Tests
 TEST_F(OutputTest, DACOutputLevels) {
     dacOutput->SetLevel(75);
@@ -198,6 +406,51 @@ TEST_F(OutputTest, DACOutputLevels) {
 
     EXPECT_GT(highLevel, lowLevel);
     EXPECT_GT(lowLevel, 0); // Due to offset
+
+    // Integer math, so the levels are exact: 75% of full scale plus 25%, clamped, and 25% while off
+    EXPECT_EQ(highLevel, 4095);
+    EXPECT_EQ(lowLevel, 1024);
+    dacOutput->SetLevel(50);
+    dacOutput->SetOffset(0);
+    dacOutput->SetPulse(true);
+    EXPECT_EQ(dacOutput->GetOutputLevel(), 2048u);
+}
+
+// While the pulse is off a DAC output holds its offset voltage, whatever the waveform and level
+TEST_F(OutputTest, DACOutputOffStateHoldsOffset) {
+    const int PPQN = 192;
+    dacOutput->SetLevel(80);
+    for (WaveformType type : {WaveformType::Square, WaveformType::Triangle, WaveformType::Sine}) {
+        dacOutput->SetWaveformType(type);
+        dacOutput->SetPulse(false);
+        dacOutput->SetOffset(0);
+        EXPECT_EQ(dacOutput->GetOutputLevel(), 0u);
+        dacOutput->SetOffset(50);
+        EXPECT_EQ(dacOutput->GetOutputLevel(), 2048u); // Half of full scale, rounded
+        dacOutput->SetOffset(100);
+        EXPECT_EQ(dacOutput->GetOutputLevel(), 4095u);
+    }
+
+    // A switched off output stops its pulse and drops to the offset too
+    dacOutput->SetWaveformType(WaveformType::Square);
+    dacOutput->SetOffset(25);
+    dacOutput->SetPulse(true);
+    dacOutput->SetOutputState(false);
+    dacOutput->Render(PPQN);
+    EXPECT_EQ(dacOutput->GetOutputLevel(), 1024u);
+}
+
+// Value descriptions are written into the caller's buffer
+TEST_F(OutputTest, ValueDescriptions) {
+    char text[DESCRIPTION_LENGTH];
+    dacOutput->SetLevel(75);
+    EXPECT_STREQ(dacOutput->GetLevelDescription(text), "75%");
+    dacOutput->SetAttack(250.0f);
+    EXPECT_STREQ(dacOutput->GetAttackDescription(text), "250ms");
+    dacOutput->SetAttack(1250.0f);
+    EXPECT_STREQ(dacOutput->GetAttackDescription(text), "1.3s");
+    dacOutput->SetDivider(9);
+    EXPECT_STREQ(dacOutput->GetDividerDescription(), "x1");
 }
 
 // Master State Control Tests
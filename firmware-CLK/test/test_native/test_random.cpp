@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "random.hpp"
+
+// The same seed gives the same sequence, different seeds do not
+TEST(Xorshift32, Reproducible) {
+    Xorshift32 a(1234);
+    Xorshift32 b(1234);
+    Xorshift32 c(1235);
+    int differences = 0;
+    for (int i = 0; i < 100; i++) {
+        uint32_t value = a.Next();
+        EXPECT_EQ(value, b.Next());
+        if (value != c.Next())
+            differences++;
+    }
+    EXPECT_GT(differences, 95);
+}
+
+// A zero seed must not lock the generator up
+TEST(Xorshift32, ZeroSeed) {
+    Xorshift32 random(0);
+    uint32_t first = random.Next();
+    EXPECT_NE(first, 0u);
+    EXPECT_NE(random.Next(), first);
+}
+
+// Bounded values stay in range and cover it evenly
+TEST(Xorshift32, BelowRange) {
+    Xorshift32 random(42);
+    int counts[10] = {0};
+    for (int i = 0; i < 100000; i++) {
+        uint32_t value = random.Below(10);
+        ASSERT_LT(value, 10u);
+        counts[value]++;
+    }
+    for (int i = 0; i < 10; i++) {
+        EXPECT_NEAR(counts[i], 10000, 500);
+    }
+}
+
+// Benchmark against the libc rand() path, timings are printed for reference only
+TEST(Xorshift32, Benchmark) {
+    const int iterations = 1000000;
+    volatile uint32_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        sink = sink + rand() % 100;
+    }
+    auto libcTime = std::chrono::steady_clock::now() - start;
+
+    Xorshift32 random(1);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        sink = sink + random.Below(100);
+    }
+    auto xorshiftTime = std::chrono::steady_clock::now() - start;
+
+    double libcNs = std::chrono::duration<double, std::nano>(libcTime).count() / iterations;
+    double xorshiftNs = std::chrono::duration<double, std::nano>(xorshiftTime).count() / iterations;
+    printf("rand: %.2f ns, Xorshift32: %.2f ns, speedup %.1fx\n", libcNs, xorshiftNs, libcNs / xorshiftNs);
+    SUCCEED();
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "wavetables.hpp"
+
+// Table end points and quarter turns
+TEST(SineTable, KeyPoints) {
+    EXPECT_EQ(sineTable.values[0], 0);
+    EXPECT_EQ(sineTable.values[SineTableSize / 4], 32767);
+    EXPECT_EQ(sineTable.values[SineTableSize / 2], 0);
+    EXPECT_EQ(sineTable.values[SineTableSize * 3 / 4], -32767);
+    EXPECT_EQ(sineTable.values[SineTableSize], 0);
+}
+
+// Interpolated values stay within 2 LSB of libm over a full turn
+TEST(SineQ15, MatchesLibm) {
+    for (uint64_t phase = 0; phase < (1ull << 32); phase += 1234567) {
+        double expected = std::sin(2.0 * M_PI * phase / 4294967296.0) * 32767.0;
+        EXPECT_NEAR(SineQ15(uint32_t(phase)), expected, 2.0);
+    }
+}
+
+// Benchmark against the float sin() the generators used before, timings are printed for reference only
+TEST(SineQ15, Benchmark) {
+    const int iterations = 1000000;
+    const uint32_t phaseStep = 0x01234567;
+    volatile float floatSink = 0.0f;
+    volatile int32_t tableSink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    float angle = 0.0f;
+    for (int i = 0; i < iterations; i++) {
+        floatSink = floatSink + sinf(angle);
+        angle += 0.0001f;
+    }
+    auto libmTime = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    uint32_t phase = 0;
+    for (int i = 0; i < iterations; i++) {
+        tableSink = tableSink + SineQ15(phase);
+        phase += phaseStep;
+    }
+    auto tableTime = std::chrono::steady_clock::now() - start;
+
+    double libmNs = std::chrono::duration<double, std::nano>(libmTime).count() / iterations;
+    double tableNs = std::chrono::duration<double, std::nano>(tableTime).count() / iterations;
+    printf("sinf: %.2f ns, SineQ15: %.2f ns, speedup %.1fx\n", libmNs, tableNs, libmNs / tableNs);
+    SUCCEED();
+}
+
+// Curve tables start and end on the expected values
+TEST(CurveTables, EndPoints) {
+    EXPECT_EQ(expRiseTable.values[0], 0);
+    EXPECT_EQ(expRiseTable.values[CurveTableSize], 32767);
+    EXPECT_EQ(expDecayTable.values[0], 32767);
+    EXPECT_NEAR(expDecayTable.values[CurveTableSize], 33, 1); // 1/1000 of full scale
+    EXPECT_EQ(log2Table.values[0], 0);
+    EXPECT_EQ(log2Table.values[CurveTableSize], 32767);
+}
+
+// Table based logarithm tracks libm over the range used by the log envelopes
+TEST(Log2Q16, MatchesLibm) {
+    for (double x = 1.0; x < 30000.0; x *= 1.07) {
+        double expected = std::log2(x);
+        EXPECT_NEAR(Log2Q16(uint32_t(x * 65536.0)) / 65536.0, expected, 0.001);
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <Arduino.h>
+#include <wiring_private.h>
+
+#include "pinouts.hpp"
+
+// Free running ADC for the CV inputs. The ADC scans the analog inputs from the lowest to the highest CV
+// pin without stopping and the DMA copies every result into a ring of recent scans, so reading a CV
+// input is a sum over memory instead of a blocking conversion. IN2 (AIN5) and IN1 (AIN7) are scanned
+// with AIN6 between them, the encoder switch, whose results are ignored.
+#define ADC_INPUTS 2
+#define ADC_SCAN_CHANNELS 3 // Inputs converted per scan, AIN5 to AIN7
+#define ADC_SCAN_DEPTH 32   // Scans kept for averaging, must be a power of two. About 1.8 ms of input
+#define ADC_SCAN_SHIFT 5    // log2(ADC_SCAN_DEPTH)
+#define ADC_DMA_CHANNEL 0   // The scan is the only DMA user here
+
+// Add prototypes for functions defined in this file
+void InitADCScan();
+void StartADCScan();
+uint16_t ReadADCScan(int input);
+
+__attribute__((aligned(16))) DmacDescriptor adcDescriptor;
+__attribute__((aligned(16))) DmacDescriptor adcWriteback;
+volatile uint16_t adcScanBuffer[ADC_SCAN_DEPTH * ADC_SCAN_CHANNELS];
+uint8_t adcScanIndex[ADC_INPUTS]; // Position of each CV input within a scan
+
+void InitADCScan() {
+    const int pins[ADC_INPUTS] = {CV_1_IN_PIN, CV_2_IN_PIN};
+
+    // The scan covers the range between the two CV inputs
+    uint8_t first = 0xFF;
+    for (int i = 0; i < ADC_INPUTS; i++) {
+        first = min(first, (uint8_t)g_APinDescription[pins[i]].ulADCChannelNumber);
+    }
+    for (int i = 0; i < ADC_INPUTS; i++) {
+        adcScanIndex[i] = g_APinDescription[pins[i]].ulADCChannelNumber - first;
+        pinPeripheral(pins[i], PIO_ANALOG);
+    }
+
+    ADC->CTRLA.bit.ENABLE = 0;
+    while (ADC->STATUS.bit.SYNCBUSY)
+        ;
+    // 48 MHz / 64 for the ADC clock and a longer sampling time for the input impedance, about 19 us per
+    // conversion. Single 12-bit samples, the averaging is done when the inputs are read.
+    ADC->CTRLB.reg = ADC_CTRLB_PRESCALER_DIV64 | ADC_CTRLB_RESSEL_12BIT | ADC_CTRLB_FREERUN;
+    ADC->AVGCTRL.reg = ADC_AVGCTRL_SAMPLENUM_1;
+    ADC->SAMPCTRL.reg = ADC_SAMPCTRL_SAMPLEN(7);
+    ADC->INPUTCTRL.reg = ADC_INPUTCTRL_MUXPOS(first) | ADC_INPUTCTRL_MUXNEG_GND | ADC_INPUTCTRL_GAIN_DIV2 |
+                         ADC_INPUTCTRL_INPUTSCAN(ADC_SCAN_CHANNELS - 1);
+    while (ADC->STATUS.bit.SYNCBUSY)
+        ;
+
+    PM->AHBMASK.reg |= PM_AHBMASK_DMAC;
+    PM->APBBMASK.reg |= PM_APBBMASK_DMAC;
+    DMAC->CTRL.reg = 0;
+    DMAC->CTRL.reg = DMAC_CTRL_SWRST;
+    while (DMAC->CTRL.reg & DMAC_CTRL_SWRST)
+        ;
+    DMAC->BASEADDR.reg = (uint32_t)&adcDescriptor;
+    DMAC->WRBADDR.reg = (uint32_t)&adcWriteback;
+    DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xF);
+
+    // One result per trigger around a descriptor that links back to itself
+    DMAC->CHID.reg = DMAC_CHID_ID(ADC_DMA_CHANNEL);
+    DMAC->CHCTRLA.reg = 0;
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+    while (DMAC->CHCTRLA.reg & DMAC_CHCTRLA_SWRST)
+        ;
+    DMAC->CHCTRLB.reg = DMAC_CHCTRLB_LVL(0) | DMAC_CHCTRLB_TRIGSRC(ADC_DMAC_ID_RESRDY) | DMAC_CHCTRLB_TRIGACT_BEAT;
+    adcDescriptor.BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_HWORD | DMAC_BTCTRL_DSTINC | DMAC_BTCTRL_BLOCKACT_NOACT;
+    adcDescriptor.BTCNT.reg = ADC_SCAN_DEPTH * ADC_SCAN_CHANNELS;
+    adcDescriptor.SRCADDR.reg = (uint32_t)&ADC->RESULT.reg;
+    adcDescriptor.DSTADDR.reg = (uint32_t)(adcScanBuffer + ADC_SCAN_DEPTH * ADC_SCAN_CHANNELS);
+    adcDescriptor.DESCADDR.reg = (uint32_t)&adcDescriptor;
+
+    StartADCScan();
+
+    // Fill the ring once so the first readings are valid
+    delayMicroseconds(2000);
+}
+
+// The DMA is waiting before the first conversion, so every scan lands at the start of its slot
+void StartADCScan() {
+    DMAC->CHID.reg = DMAC_CHID_ID(ADC_DMA_CHANNEL);
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
+    ADC->CTRLA.bit.ENABLE = 1;
+    while (ADC->STATUS.bit.SYNCBUSY)
+        ;
+    ADC->SWTRIG.reg = ADC_SWTRIG_START;
+}
+
+// Average of the scans in the ring, 12-bit like a single conversion
+uint16_t ReadADCScan(int input) {
+    uint32_t sum = 0;
+    for (int scan = 0; scan < ADC_SCAN_DEPTH; scan++) {
+        sum += adcScanBuffer[scan * ADC_SCAN_CHANNELS + adcScanIndex[input]];
+    }
+    return sum >> ADC_SCAN_SHIFT;
+}
@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <Wire.h>
 
+#include "adcscan.cpp"
 #include "pinouts.hpp"
 
 // Add prototypes for functions defined in this file
@@ -22,12 +23,7 @@ Adafruit_MCP4725 dac;
 
 // Handle IO devices initialization
 void InitIO() {
-    // ADC settings. These increase ADC reading stability but at the cost of cycle time. Takes around 0.7ms for one reading with these
-    REG_ADC_AVGCTRL |= ADC_AVGCTRL_SAMPLENUM_1;
-    ADC->AVGCTRL.reg = ADC_AVGCTRL_SAMPLENUM_128 | ADC_AVGCTRL_ADJRES(4);
-
     analogWriteResolution(10);
-    analogReadResolution(12);
 
     pinMode(LED_BUILTIN, OUTPUT);        // LED
     pinMode(CLK_IN_PIN, INPUT_PULLDOWN); // CLK in
@@ -36,6 +32,7 @@ void InitIO() {
     pinMode(ENCODER_SW, INPUT_PULLUP);   // push sw
     pinMode(OUT_PIN_1, OUTPUT);          // CH1 EG out
     pinMode(OUT_PIN_2, OUTPUT);          // CH2 EG out
+    InitADCScan();                       // IN1 and IN2 are sampled in the background from here on
 
     // Initialize the DAC
     dac.begin(0x60);
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <Adafruit_SSD1306.h>
+#include <Arduino.h>
+#include <Wire.h>
+
+// Partial display updates. A copy of the last frame sent is kept next to the Adafruit_SSD1306 buffer and
+// only the changed columns of each 8-row page go over I2C, instead of the full kilobyte display() sends.
+// Changes are queued and sent a chunk at a time from the main loop within a bus time budget, so the
+// DAC writes in between never wait for more than the budget and one chunk.
+#define DISPLAY_PAGES 8               // 8-pixel rows of the 128x64 display
+#define DISPLAY_COLUMNS 128
+#define DISPLAY_CHUNK_SIZE 31         // Data bytes per transmission, fits the Wire buffer with the data prefix
+#define DISPLAY_I2C_CLOCK 400000      // Bus clock while sending, as Adafruit_SSD1306 uses
+#define DISPLAY_I2C_CLOCK_IDLE 100000 // Bus clock restored afterwards, as Adafruit_SSD1306 does
+#define DISPLAY_BUS_BUDGET 1000       // Microseconds of bus time per call to ServiceDisplay
+
+// Add prototypes for functions defined in this file
+void InitDisplayUpdate(Adafruit_SSD1306 *oled, uint8_t address);
+void UpdateDisplay();
+void ServiceDisplay();
+bool IsDisplayBusy();
+void QueueDisplayColumns(uint8_t page, uint8_t first, uint8_t last);
+void SendDisplayCommands(uint8_t page, uint8_t first, uint8_t last);
+void SendDisplayChunk();
+
+uint8_t *displayBuffer = nullptr;
+uint8_t displayAddress = 0;
+uint8_t displaySent[DISPLAY_PAGES * DISPLAY_COLUMNS]; // Frame as last queued, chunks are sent from here
+unsigned long displayBusBudget = DISPLAY_BUS_BUDGET;
+
+// Pages still to send, their column ranges and the position within the current one
+uint8_t displayPages = 0;
+uint8_t displayFirstColumn[DISPLAY_PAGES];
+uint8_t displayLastColumn[DISPLAY_PAGES];
+uint8_t displayPage = 0;
+uint8_t displayColumn = 0;
+bool displayWindowSent = false;
+
+// Start tracking changes, the buffer must match what the display shows at this point
+void InitDisplayUpdate(Adafruit_SSD1306 *oled, uint8_t address) {
+    displayBuffer = oled->getBuffer();
+    displayAddress = address;
+    memcpy(displaySent, displayBuffer, sizeof(displaySent));
+}
+
+// Queue the columns of every page that changed since the last update, ServiceDisplay sends them
+void UpdateDisplay() {
+    for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+        const uint8_t *source = displayBuffer + page * DISPLAY_COLUMNS;
+        uint8_t *sent = displaySent + page * DISPLAY_COLUMNS;
+        int first = 0;
+        while (first < DISPLAY_COLUMNS && source[first] == sent[first]) {
+            first++;
+        }
+        if (first == DISPLAY_COLUMNS) {
+            continue;
+        }
+        int last = DISPLAY_COLUMNS - 1;
+        while (source[last] == sent[last]) {
+            last--;
+        }
+        memcpy(sent + first, source + first, last - first + 1);
+        QueueDisplayColumns(page, first, last);
+    }
+}
+
+// Send queued chunks until the bus time budget is used up, called once per pass of the main loop
+void ServiceDisplay() {
+    if (displayPages == 0) {
+        return;
+    }
+    Wire.setClock(DISPLAY_I2C_CLOCK);
+    unsigned long start = micros();
+    while (displayPages != 0 && micros() - start < displayBusBudget) {
+        SendDisplayChunk();
+    }
+    Wire.setClock(DISPLAY_I2C_CLOCK_IDLE);
+}
+
+bool IsDisplayBusy() {
+    return displayPages != 0;
+}
+
+// Add columns to a page's range. A page that is already being sent starts over, so the display
+// always ends up showing the frame as it was at the last update.
+void QueueDisplayColumns(uint8_t page, uint8_t first, uint8_t last) {
+    uint8_t mask = 1 << page;
+    if (displayPages & mask) {
+        first = min(first, displayFirstColumn[page]);
+        last = max(last, displayLastColumn[page]);
+        if (page == displayPage) {
+            displayWindowSent = false;
+        }
+    }
+    displayFirstColumn[page] = first;
+    displayLastColumn[page] = last;
+    displayPages |= mask;
+}
+
+// Point the display at the column range of one page
+void SendDisplayCommands(uint8_t page, uint8_t first, uint8_t last) {
+    Wire.beginTransmission(displayAddress);
+    Wire.write((uint8_t)0x00); // Commands follow
+    Wire.write((uint8_t)SSD1306_COLUMNADDR);
+    Wire.write(first);
+    Wire.write(last);
+    Wire.write((uint8_t)SSD1306_PAGEADDR);
+    Wire.write(page);
+    Wire.write(page);
+    Wire.endTransmission();
+}
+
+// Send the next piece of the lowest queued page, either its window commands or one chunk of data
+void SendDisplayChunk() {
+    if (!displayWindowSent) {
+        displayPage = __builtin_ctz(displayPages);
+        displayColumn = displayFirstColumn[displayPage];
+        displayWindowSent = true;
+        SendDisplayCommands(displayPage, displayColumn, displayLastColumn[displayPage]);
+        return;
+    }
+    const uint8_t *chunk = displaySent + displayPage * DISPLAY_COLUMNS + displayColumn;
+    uint8_t length = min(DISPLAY_CHUNK_SIZE, displayLastColumn[displayPage] + 1 - displayColumn);
+    displayColumn += length;
+    if (displayColumn > displayLastColumn[displayPage]) {
+        displayPages &= ~(1 << displayPage);
+        displayWindowSent = false;
+    }
+    Wire.beginTransmission(displayAddress);
+    Wire.write((uint8_t)0x40); // Data follows
+    Wire.write(chunk, length);
+    Wire.endTransmission();
+}
@@ -9,6 +9,7 @@
 
 // Load local libraries
 #include "boardIO.cpp"
+#include "displayupdate.cpp"
 #include "loadsave.cpp"
 #include "pinouts.hpp"
 #include "quantizer.cpp"
@@ -17,7 +18,6 @@
 #include "version.hpp"
 
 // ADC Calibration settings
-const int ADC_THRESHOLD = 5; // Threshold for ADC stability
 // float ADCCal[2] = {1.026, 1.026}; // ADC readings for the channels
 // int ADCOffset[2] = {25, 25};      // ADC offset for the channels
 float ADCCal[2] = {1.0180, 1.0180}; // ADC readings for the channels
@@ -149,7 +149,7 @@ void HandleEncoderClick() {
             display.setTextColor(BLACK, WHITE);
             display.setCursor(1, 40);
             display.print("LOADED");
-            display.display();
+            UpdateDisplay();
             unsigned long saveMessageStartTime = millis();
             while (millis() - saveMessageStartTime < 1000) {
                 HandleIO();
@@ -164,7 +164,7 @@ void HandleEncoderClick() {
             display.setTextColor(BLACK, WHITE);
             display.setCursor(1, 40);
             display.print("LOADED");
-            display.display();
+            UpdateDisplay();
             unsigned long saveMessageStartTime = millis();
             while (millis() - saveMessageStartTime < 1000) {
                 HandleIO();
@@ -189,7 +189,7 @@ void HandleEncoderClick() {
             display.setTextColor(BLACK, WHITE);
             display.setCursor(10, 40);
             display.print("SAVED");
-            display.display();
+            UpdateDisplay();
             unsigned long saveMessageStartTime = millis();
             while (millis() - saveMessageStartTime < 1000) {
                 HandleIO();
@@ -324,7 +324,7 @@ void RedrawDisplay() {
         display.setCursor(120, 0);
         display.print("*");
     }
-    display.display();
+    UpdateDisplay();
     displayRefresh = 0;
 }
 
@@ -512,19 +512,9 @@ void HandleOLED() {
     }
 }
 
-void AdjustADCReadings(int CV_IN_PIN, int ch) {
-    // Apply calibration
-    float calibratedReading = max((analogRead(CV_IN_PIN) - ADCOffset[ch]) * ADCCal[ch], 0.0f);
-
-    // Wait for the ADC to stabilize for a few readings
-    for (int count = 0; count < 10; count++) {
-        float newReading = max((analogRead(CV_IN_PIN) - ADCOffset[ch]) * ADCCal[ch], 0.0f);
-        if (abs(calibratedReading - newReading) <= ADC_THRESHOLD) {
-            break;
-        }
-        calibratedReading = newReading;
-    }
-
+void AdjustADCReadings(int ch) {
+    // Apply calibration to the average of the recent conversions
+    float calibratedReading = max((ReadADCScan(ch) - ADCOffset[ch]) * ADCCal[ch], 0.0f);
     channelADC[ch] = calibratedReading;
 }
 
@@ -538,8 +528,8 @@ void HandleInputs() {
     oldQuantizedNoteIdx[1] = quantizedNoteIdx[1];
 
     //-------------------------------Analog read and qnt setting--------------------------
-    AdjustADCReadings(CV_1_IN_PIN, 0);
-    AdjustADCReadings(CV_2_IN_PIN, 1);
+    AdjustADCReadings(0);
+    AdjustADCReadings(1);
 
     QuantizeCV(channelADC[0], oldChannelADC[0], quantizerThresholdBuff[0], channelSensitivity[0], octaveShift[0], &CVOutput[0]);
     QuantizeCV(channelADC[1], oldChannelADC[1], quantizerThresholdBuff[1], channelSensitivity[1], octaveShift[1], &CVOutput[1]);
@@ -614,6 +604,9 @@ void HandleIO() {
     HandleEncoderPosition();
 
     HandleInputs();
+
+    // Send a slice of any queued display changes, the inputs above never wait for a whole frame
+    ServiceDisplay();
 }
 
 void loop() {
@@ -646,6 +639,7 @@ void setup() {
     display.setCursor(80, 54);
     display.print("V" VERSION);
     display.display();
+    InitDisplayUpdate(&display, OLED_ADDRESS);
     delay(1500);
 
     // Load scale and note settings from flash memory
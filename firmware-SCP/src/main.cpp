@@ -11,6 +11,7 @@
 // Load local libraries
 #include "boardIO.cpp"
 #include "definitions.hpp"
+#include "displayupdate.cpp"
 #include "pinouts.hpp"
 #include "splash.hpp"
 #include "version.hpp"
@@ -280,7 +281,7 @@ void HandleDisplay() {
         display.print(t4);
     }
 
-    display.display();
+    UpdateDisplay();
 }
 
 // // Handle encoder button click
@@ -446,6 +447,7 @@ void setup() {
     display.setCursor(80, 54);
     display.print("V" VERSION);
     display.display();
+    InitDisplayUpdate(&display, OLED_ADDRESS);
     delay(1500);
 }
 
@@ -454,6 +456,9 @@ void HandleIO() {
     HandleEncoderClick();
 
     HandleEncoderPosition();
+
+    // Send a slice of any queued display changes
+    ServiceDisplay();
 }
 
 // // Main loop